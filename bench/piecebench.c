@@ -0,0 +1,738 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ *
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *   Or,
+ *
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ *
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ *
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+
+/*
+ * piecebench: renders fixed piece trees off screen and reports the frame
+ * times, the memdcs created and the pixels repainted of every scenario.
+ *
+ *   piecebench [-n frames] [table] [vtable] [panel] [navigation] [iconflow]
+ *
+ * The dummy GAL and IAL engines are used unless MG_GAL_ENGINE and
+ * MG_IAL_ENGINE are set in the environment, so that runs are repeatable
+ * on machines without a display.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgeff/mgeff.h>
+#include <mgncs/mgncs.h>
+#include <mgncs4touch/mgncs4touch.h>
+
+#define BENCH_W 480
+#define BENCH_H 800
+#define BENCH_MODE "480x800-32bpp"
+#define DEF_FRAMES 300
+
+#define TABLE_ROWS 1000
+#define VTABLE_ROWS 10000
+#define ROW_H 44
+#define SCROLL_STEP 23
+
+#define GRID_COLS 6
+#define GRID_ROWS 8
+
+#define ICON_NUM 16
+#define ICON_W 160
+#define ICON_H 120
+
+extern void GUIAPI UpdateInvalidRect (HWND hWnd, BOOL bErase);
+
+typedef struct _BENCH_STATS {
+    const char *name;
+    int nr_frames;
+    double *times;          /* ms of every frame */
+    double pixels;          /* pixels repainted */
+    unsigned int memdcs;    /* memdcs created */
+    double first;           /* ms from setup to the end of the first paint */
+    unsigned int pieces;    /* pieces in the tree after the last frame */
+} BENCH_STATS;
+
+typedef struct _BENCH_SCENARIO {
+    const char *name;
+    /* builds the tree, returns the window it is painted in */
+    HWND (*setup)(HWND parent);
+    /* changes the tree for frame i */
+    void (*step)(int i);
+    void (*teardown)(void);
+} BENCH_SCENARIO;
+
+static HWND s_mainHwnd;
+static mContainerCtrl *s_ctnr;
+
+static double s_msecs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static mContainerCtrl *s_createContainer(HWND parent, mHotPiece *body)
+{
+    mContainerCtrl *ctnr = (mContainerCtrl*)ncsCreateWindow(NCSCTRL_CONTAINERCTRL,
+            "ContainerCtrl",
+            WS_VISIBLE, 0, 0,
+            0, 0, BENCH_W, BENCH_H,
+            parent,
+            NULL, NULL, NULL, 0);
+
+    /* paint as soon as asked, the bench paces the frames itself */
+    _c(ctnr)->setProperty(ctnr, NCSP_CTNRCTRL_FRAME_INTERVAL, 0);
+    _c(ctnr)->setBody(ctnr, body);
+    return ctnr;
+}
+
+static unsigned int s_memdcCount(mContainerCtrl *ctnr)
+{
+    SURFACEPOOL_STATS pool_stats;
+    LAYERCACHE_STATS layer_stats;
+    unsigned int count = 0;
+
+    LayerCache_getStats(&layer_stats);
+    count += layer_stats.misses;
+
+    if (ctnr && ctnr->body && INSTANCEOF(ctnr->body, mPanelPiece)) {
+        SurfacePool_getStats(PanelPiece_getSurfacePool((mHotPiece*)ctnr->body), &pool_stats);
+        count += pool_stats.misses;
+    }
+    return count;
+}
+
+/* pieces in the tree of piece, piece included */
+static unsigned int s_pieceCount(mHotPiece *piece)
+{
+    unsigned int count = 1;
+
+    if (INSTANCEOF(piece, mPanelPiece)) {
+        mPanelPiece *panel = (mPanelPiece*)piece;
+        ITEM_CURSOR cursor;
+        mPieceItem *item;
+
+        FOR_EACH_ITEM(panel->itemManager, cursor, item) {
+            count += s_pieceCount(item->piece);
+        }
+    }
+    return count;
+}
+
+/* pixels the next paint of hwnd is going to touch */
+static double s_pendingPixels(HWND hwnd)
+{
+    mWidget *widget = (mWidget*)ncsObjFromHandle(hwnd);
+    RECT rc;
+
+    if (widget && widget->body && INSTANCEOF(widget->body, mPanelPiece)) {
+        mPanelPiece *body = (mPanelPiece*)widget->body;
+        if (body->nr_damage_rects > 0) {
+            double pixels = 0;
+            int i;
+            for (i = 0; i < body->nr_damage_rects; ++i) {
+                pixels += (double)RECTW(body->damageRects[i]) * RECTH(body->damageRects[i]);
+            }
+            return pixels;
+        }
+    }
+
+    if (GetUpdateRect(hwnd, &rc) && !IsRectEmpty(&rc))
+        return (double)RECTW(rc) * RECTH(rc);
+    return 0;
+}
+
+/* ---- 1000 rows table view, scrolled up and down ---- */
+
+typedef struct _mBenchTableView mBenchTableView;
+typedef struct _mBenchTableViewClass mBenchTableViewClass;
+
+#define mBenchTableViewHeader(clss) \
+    mTableViewPieceHeader(clss)
+
+#define mBenchTableViewClassHeader(clss, superCls) \
+    mTableViewPieceClassHeader(clss, superCls)
+
+struct _mBenchTableView
+{
+    mBenchTableViewHeader(mBenchTableView)
+};
+
+struct _mBenchTableViewClass
+{
+    mBenchTableViewClassHeader(mBenchTableView, mTableViewPiece)
+};
+
+static mBenchTableView *s_table;
+static int s_tableScroll;
+
+static mTableViewItemPiece* mBenchTableView_createItemForRow(mBenchTableView* self, const mIndexPath* indexpath)
+{
+    static char labels[TABLE_ROWS][16];
+    RECT rc = {0, 0, BENCH_W, ROW_H};
+    mPanelPiece *panel = NEWPIECE(mPanelPiece);
+    mHotPiece *txt_piece = (mHotPiece*)NEWPIECE(mTextPiece);
+    mTableViewItemPiece *item = NEWPIECEEX(mTableViewItemPiece, 0);
+
+    _c(panel)->setRect(panel, &rc);
+
+    snprintf(labels[indexpath->row], sizeof(labels[0]), "row %d", indexpath->row);
+    SetRect(&rc, 0, 0, 200, 24);
+    _c(txt_piece)->setRect(txt_piece, &rc);
+    _c(txt_piece)->setProperty(txt_piece, NCSP_LABELPIECE_LABEL, (DWORD)labels[indexpath->row]);
+    _c(panel)->addContent(panel, txt_piece, 16, (ROW_H - 24) / 2);
+
+    _c(item)->setUserPiece(item, (mHotPiece*)panel);
+    SetRect(&rc, 0, 0, BENCH_W, ROW_H);
+    _c(item)->setRect(item, &rc);
+    return item;
+}
+
+static int mBenchTableView_numberOfSections(mBenchTableView* self)
+{
+    return 1;
+}
+
+static int mBenchTableView_numberOfRowsInSection(mBenchTableView* self, int section)
+{
+    return TABLE_ROWS;
+}
+
+static const char* mBenchTableView_titleForSection(mBenchTableView* self, int section)
+{
+    return "rows";
+}
+
+static const char* mBenchTableView_indexForSection(mBenchTableView* self, int section)
+{
+    return "r";
+}
+
+BEGIN_MINI_CLASS(mBenchTableView, mTableViewPiece)
+    CLASS_METHOD_MAP(mBenchTableView, createItemForRow)
+    CLASS_METHOD_MAP(mBenchTableView, numberOfSections)
+    CLASS_METHOD_MAP(mBenchTableView, numberOfRowsInSection)
+    CLASS_METHOD_MAP(mBenchTableView, titleForSection)
+    CLASS_METHOD_MAP(mBenchTableView, indexForSection)
+END_MINI_CLASS
+
+static HWND table_setup(HWND parent)
+{
+    RECT rc = {0, 0, BENCH_W, BENCH_H};
+
+    s_table = NEWPIECEEX(mBenchTableView, NCS_TABLEVIEW_INDEX_STYLE);
+    _c(s_table)->setRect(s_table, &rc);
+    _c(s_table)->reloadData(s_table);
+    s_tableScroll = 0;
+
+    s_ctnr = s_createContainer(parent, (mHotPiece*)s_table);
+    return s_ctnr ? s_ctnr->hwnd : HWND_INVALID;
+}
+
+static void table_step(int i)
+{
+    /* sweep the whole list down and back up */
+    int range = TABLE_ROWS * ROW_H - BENCH_H;
+    int pos = (i * SCROLL_STEP) % (2 * range);
+
+    s_tableScroll = pos < range ? pos : 2 * range - pos;
+    _c(s_table)->moveViewport(s_table, 0, s_tableScroll);
+}
+
+/* ---- 10000 rows virtualized table view, rows recycled while scrolling ---- */
+
+typedef struct _mBenchVTableView mBenchVTableView;
+typedef struct _mBenchVTableViewClass mBenchVTableViewClass;
+
+#define mBenchVTableViewHeader(clss) \
+    mTableViewPieceHeader(clss)
+
+#define mBenchVTableViewClassHeader(clss, superCls) \
+    mTableViewPieceClassHeader(clss, superCls)
+
+struct _mBenchVTableView
+{
+    mBenchVTableViewHeader(mBenchVTableView)
+};
+
+struct _mBenchVTableViewClass
+{
+    mBenchVTableViewClassHeader(mBenchVTableView, mTableViewPiece)
+};
+
+static mBenchVTableView *s_vtable;
+
+static mTableViewItemPiece* mBenchVTableView_createItemForRow(mBenchVTableView* self, const mIndexPath* indexpath)
+{
+    static char labels[VTABLE_ROWS][16];
+    RECT rc = {0, 0, BENCH_W, ROW_H};
+    mTableViewItemPiece *item = _c(self)->dequeueReusableRow(self, 0);
+    mHotPiece *txt_piece;
+
+    snprintf(labels[indexpath->row], sizeof(labels[0]), "row %d", indexpath->row);
+
+    if (item) {
+        /* add_data keeps the label of a recycled row */
+        txt_piece = (mHotPiece*)item->add_data;
+        _c(txt_piece)->setProperty(txt_piece, NCSP_LABELPIECE_LABEL, (DWORD)labels[indexpath->row]);
+        return item;
+    }
+
+    item = NEWPIECEEX(mTableViewItemPiece, 0);
+    {
+        mPanelPiece *panel = NEWPIECE(mPanelPiece);
+
+        txt_piece = (mHotPiece*)NEWPIECE(mTextPiece);
+        _c(panel)->setRect(panel, &rc);
+        SetRect(&rc, 0, 0, 200, 24);
+        _c(txt_piece)->setRect(txt_piece, &rc);
+        _c(txt_piece)->setProperty(txt_piece, NCSP_LABELPIECE_LABEL, (DWORD)labels[indexpath->row]);
+        _c(panel)->addContent(panel, txt_piece, 16, (ROW_H - 24) / 2);
+
+        _c(item)->setUserPiece(item, (mHotPiece*)panel);
+        SetRect(&rc, 0, 0, BENCH_W, ROW_H);
+        _c(item)->setRect(item, &rc);
+        item->add_data = (DWORD)txt_piece;
+    }
+    return item;
+}
+
+static int mBenchVTableView_numberOfSections(mBenchVTableView* self)
+{
+    return 1;
+}
+
+static int mBenchVTableView_numberOfRowsInSection(mBenchVTableView* self, int section)
+{
+    return VTABLE_ROWS;
+}
+
+static int mBenchVTableView_reuseTypeForRow(mBenchVTableView* self, const mIndexPath* indexpath)
+{
+    return 0;
+}
+
+BEGIN_MINI_CLASS(mBenchVTableView, mTableViewPiece)
+    CLASS_METHOD_MAP(mBenchVTableView, createItemForRow)
+    CLASS_METHOD_MAP(mBenchVTableView, numberOfSections)
+    CLASS_METHOD_MAP(mBenchVTableView, numberOfRowsInSection)
+    CLASS_METHOD_MAP(mBenchVTableView, reuseTypeForRow)
+END_MINI_CLASS
+
+static HWND vtable_setup(HWND parent)
+{
+    RECT rc = {0, 0, BENCH_W, BENCH_H};
+
+    s_vtable = NEWPIECEEX(mBenchVTableView, NCS_TABLEVIEW_INDEX_STYLE);
+    _c(s_vtable)->setRect(s_vtable, &rc);
+    _c(s_vtable)->setVirtualized(s_vtable, TRUE);
+    s_vtable->rowHeight = ROW_H;
+    _c(s_vtable)->reloadData(s_vtable);
+
+    s_ctnr = s_createContainer(parent, (mHotPiece*)s_vtable);
+    return s_ctnr ? s_ctnr->hwnd : HWND_INVALID;
+}
+
+static void vtable_step(int i)
+{
+    /* the same sweep as the table, over ten times the rows */
+    int range = VTABLE_ROWS * ROW_H - BENCH_H;
+    int pos = (i * SCROLL_STEP) % (2 * range);
+
+    _c(s_vtable)->moveViewport(s_vtable, 0, pos < range ? pos : 2 * range - pos);
+}
+
+/* ---- nested panels with translucent and scaled children ---- */
+
+static mPanelPiece *s_grid[GRID_ROWS * GRID_COLS];
+static mPanelPiece *s_gridInner[GRID_ROWS * GRID_COLS];
+
+static mPanelPiece *s_createCell(int index)
+{
+    static char labels[GRID_ROWS * GRID_COLS][8];
+    RECT rc = {0, 0, BENCH_W / GRID_COLS, BENCH_H / GRID_ROWS};
+    mPanelPiece *cell = NEWPIECE(mPanelPiece);
+    mPanelPiece *inner = NEWPIECE(mPanelPiece);
+    mShapeTransRoundPiece *bk;
+    mHotPiece *txt_piece = (mHotPiece*)NEWPIECE(mTextPiece);
+
+    _c(cell)->setRect(cell, &rc);
+    bk = _c(cell)->getBkgndPiece(cell);
+    _c(bk)->setProperty(bk, NCSP_TRANROUND_BKCOLOR, 0xFF000000 | (index * 0x0A1B2C));
+
+    InflateRect(&rc, -8, -8);
+    OffsetRect(&rc, -rc.left, -rc.top);
+    _c(inner)->setRect(inner, &rc);
+    bk = _c(inner)->getBkgndPiece(inner);
+    _c(bk)->setProperty(bk, NCSP_TRANROUND_BKCOLOR, 0xC0FFFFFF);
+
+    snprintf(labels[index], sizeof(labels[0]), "%d", index);
+    SetRect(&rc, 0, 0, 40, 20);
+    _c(txt_piece)->setRect(txt_piece, &rc);
+    _c(txt_piece)->setProperty(txt_piece, NCSP_LABELPIECE_LABEL, (DWORD)labels[index]);
+
+    _c(inner)->addContent(inner, txt_piece, 4, 4);
+    _c(cell)->addContent(cell, (mHotPiece*)inner, 8, 8);
+    s_gridInner[index] = inner;
+    return cell;
+}
+
+static HWND panel_setup(HWND parent)
+{
+    RECT rc = {0, 0, BENCH_W, BENCH_H};
+    mPanelPiece *body = NEWPIECE(mPanelPiece);
+    int i;
+
+    _c(body)->setRect(body, &rc);
+    for (i = 0; i < GRID_ROWS * GRID_COLS; ++i) {
+        s_grid[i] = s_createCell(i);
+        _c(body)->addContent(body, (mHotPiece*)s_grid[i],
+                (i % GRID_COLS) * (BENCH_W / GRID_COLS),
+                (i / GRID_COLS) * (BENCH_H / GRID_ROWS));
+        if (i % 2)
+            _c(body)->setPieceAlpha(body, (mHotPiece*)s_grid[i], 160);
+    }
+
+    s_ctnr = s_createContainer(parent, (mHotPiece*)body);
+    return s_ctnr ? s_ctnr->hwnd : HWND_INVALID;
+}
+
+static void panel_step(int i)
+{
+    mPanelPiece *body = (mPanelPiece*)s_ctnr->body;
+    int index = i % (GRID_ROWS * GRID_COLS);
+    mPanelPiece *cell = s_grid[index];
+    float scale = 0.5f + (i % 20) / 20.0f;
+
+    switch (i % 3) {
+        case 0:
+            _c(body)->scalePiece(body, (mHotPiece*)cell, scale, scale);
+            break;
+        case 1:
+            _c(body)->setPieceAlpha(body, (mHotPiece*)cell, 64 + (i * 37) % 192);
+            break;
+        default:
+            /* moves a grandchild, damages through two levels */
+            _c(cell)->movePiece(cell, (mHotPiece*)s_gridInner[index],
+                    8 + i % 4, 8 - i % 4);
+            break;
+    }
+}
+
+/* ---- navigation panel pushing and popping one view ---- */
+
+static mNavigationPanelPiece *s_nav;
+static mNavigationItem *s_navItems[2];
+
+static mNavigationItem *s_createNavItem(const char *title, DWORD color)
+{
+    RECT rc = {0, 0, BENCH_W, BENCH_H};
+    mPanelPiece *content = NEWPIECE(mPanelPiece);
+    mShapeTransRoundPiece *bk;
+
+    _c(content)->setRect(content, &rc);
+    bk = _c(content)->getBkgndPiece(content);
+    _c(bk)->setProperty(bk, NCSP_TRANROUND_BKCOLOR, color);
+    return ncsCreateNavigationItem((mHotPiece*)content, title, NAVIGATION_STYLE_NORMAL);
+}
+
+static HWND navigation_setup(HWND parent)
+{
+    RECT rc = {0, 0, BENCH_W, BENCH_H};
+
+    s_navItems[0] = s_createNavItem("root", 0xFF3060A0);
+    s_navItems[1] = s_createNavItem("detail", 0xFFA06030);
+    /* keep the pushed item alive across the pops */
+    ADDREF(s_navItems[1]);
+
+    s_nav = ncsCreateNavigationPanelPieceWithRootView(s_navItems[0]);
+    _c(s_nav)->setRect(s_nav, &rc);
+
+    s_ctnr = s_createContainer(parent, (mHotPiece*)s_nav);
+    return s_ctnr ? s_ctnr->hwnd : HWND_INVALID;
+}
+
+static void navigation_step(int i)
+{
+    /* every frame is a whole transition, push and pop run synchronously */
+    if (i % 2 == 0)
+        _c(s_nav)->push(s_nav, s_navItems[1]);
+    else
+        _c(s_nav)->pop(s_nav);
+}
+
+static void navigation_teardown(void)
+{
+    if (!_c(s_nav)->currentIsRoot(s_nav))
+        _c(s_nav)->pop(s_nav);
+    UNREF(s_navItems[1]);
+}
+
+/* ---- icon flow spinning through its icons ---- */
+
+static mIconFlow *s_iconflow;
+static BITMAP s_icons[ICON_NUM];
+
+static HWND iconflow_setup(HWND parent)
+{
+    NCS_ICONFLOW_ITEMINFO info;
+    int i, pos = 0;
+
+    s_iconflow = (mIconFlow*)ncsCreateWindow(NCSCTRL_ICONFLOW,
+            "IconFlow",
+            WS_VISIBLE, WS_EX_NONE, 0,
+            0, 0, BENCH_W, BENCH_H,
+            parent,
+            NULL, NULL, NULL, 0);
+    if (!s_iconflow)
+        return HWND_INVALID;
+
+    for (i = 0; i < ICON_NUM; ++i) {
+        if (!InitBitmap(HDC_SCREEN, ICON_W, ICON_H, 0, NULL, &s_icons[i]))
+            return HWND_INVALID;
+        memset(s_icons[i].bmBits, 0x10 * i, s_icons[i].bmPitch * ICON_H);
+
+        memset(&info, 0, sizeof(NCS_ICONFLOW_ITEMINFO));
+        info.bmp = &s_icons[i];
+        info.index = i;
+        info.label = "icon";
+        _c(s_iconflow)->addItem(s_iconflow, &info, &pos);
+    }
+    _c(s_iconflow)->setIconSize(s_iconflow, ICON_W, ICON_H);
+    _c(s_iconflow)->setCurSel(s_iconflow, 0);
+    return s_iconflow->hwnd;
+}
+
+static void iconflow_step(int i)
+{
+    /* the same quarter steps the arrow keys make */
+    s_iconflow->key += 0.25f;
+    while (s_iconflow->key >= ICON_NUM)
+        s_iconflow->key -= ICON_NUM;
+    InvalidateRect(s_iconflow->hwnd, NULL, FALSE);
+}
+
+static void iconflow_teardown(void)
+{
+    int i;
+
+    DestroyWindow(s_iconflow->hwnd);
+    s_iconflow = NULL;
+    for (i = 0; i < ICON_NUM; ++i)
+        UnloadBitmap(&s_icons[i]);
+}
+
+static BENCH_SCENARIO s_scenarios[] = {
+    {"table", table_setup, table_step, NULL},
+    {"vtable", vtable_setup, vtable_step, NULL},
+    {"panel", panel_setup, panel_step, NULL},
+    {"navigation", navigation_setup, navigation_step, navigation_teardown},
+    {"iconflow", iconflow_setup, iconflow_step, iconflow_teardown},
+};
+
+static int s_cmpTime(const void *a, const void *b)
+{
+    double d = *(const double*)a - *(const double*)b;
+    return d < 0 ? -1 : (d > 0 ? 1 : 0);
+}
+
+static double s_percentile(const double *sorted, int n, int pct)
+{
+    int idx = (n * pct + 99) / 100 - 1;
+    return sorted[idx < 0 ? 0 : idx];
+}
+
+static BOOL s_runScenario(const BENCH_SCENARIO *scenario, int nr_frames, BENCH_STATS *stats)
+{
+    unsigned int memdcs;
+    double setup;
+    HWND hwnd;
+    int i;
+
+    memset(stats, 0, sizeof(BENCH_STATS));
+    stats->name = scenario->name;
+    stats->times = (double*)malloc(nr_frames * sizeof(double));
+    if (!stats->times)
+        return FALSE;
+
+    s_ctnr = NULL;
+    LayerCache_resetStats();
+    setup = s_msecs();
+    hwnd = scenario->setup(s_mainHwnd);
+    if (hwnd == HWND_INVALID) {
+        fprintf(stderr, "piecebench: failed to set up %s.\n", scenario->name);
+        free(stats->times);
+        stats->times = NULL;
+        return FALSE;
+    }
+
+    /* the first paint builds the tree caches, it is not a frame */
+    UpdateWindow(hwnd, TRUE);
+    stats->first = s_msecs() - setup;
+    memdcs = s_memdcCount(s_ctnr);
+
+    for (i = 0; i < nr_frames; ++i) {
+        double start = s_msecs();
+
+        scenario->step(i);
+        PieceAnim_flush();
+        stats->pixels += s_pendingPixels(hwnd);
+        UpdateInvalidRect(hwnd, FALSE);
+
+        stats->times[i] = s_msecs() - start;
+    }
+    stats->nr_frames = nr_frames;
+    stats->memdcs = s_memdcCount(s_ctnr) - memdcs;
+    if (s_ctnr && s_ctnr->body)
+        stats->pieces = s_pieceCount((mHotPiece*)s_ctnr->body);
+
+    if (scenario->teardown)
+        scenario->teardown();
+    if (s_ctnr) {
+        DestroyWindow(s_ctnr->hwnd);
+        s_ctnr = NULL;
+    }
+    return TRUE;
+}
+
+static void s_report(BENCH_STATS *stats)
+{
+    double total = 0;
+    int i, n = stats->nr_frames;
+
+    for (i = 0; i < n; ++i)
+        total += stats->times[i];
+    qsort(stats->times, n, sizeof(double), s_cmpTime);
+
+    printf("%-12s %6d %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8u %8u %12.0f\n",
+            stats->name, n, stats->first, total / n,
+            s_percentile(stats->times, n, 50),
+            s_percentile(stats->times, n, 90),
+            s_percentile(stats->times, n, 99),
+            stats->times[n - 1],
+            stats->memdcs, stats->pieces, stats->pixels / n);
+}
+
+static void s_usage(const char *prog)
+{
+    unsigned int i;
+
+    fprintf(stderr, "usage: %s [-n frames] [scenario...]\nscenarios:", prog);
+    for (i = 0; i < TABLESIZE(s_scenarios); ++i)
+        fprintf(stderr, " %s", s_scenarios[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, const char *argv[])
+{
+    BOOL selected[TABLESIZE(s_scenarios)];
+    BOOL any = FALSE;
+    int nr_frames = DEF_FRAMES;
+    unsigned int i, j;
+    int ret = 0;
+
+    memset(selected, 0, sizeof(selected));
+    for (i = 1; i < (unsigned int)argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < (unsigned int)argc) {
+            nr_frames = atoi(argv[++i]);
+            continue;
+        }
+        for (j = 0; j < TABLESIZE(s_scenarios); ++j) {
+            if (strcmp(argv[i], s_scenarios[j].name) == 0)
+                break;
+        }
+        if (j == TABLESIZE(s_scenarios)) {
+            s_usage(argv[0]);
+            return 1;
+        }
+        selected[j] = any = TRUE;
+    }
+    if (nr_frames <= 0) {
+        s_usage(argv[0]);
+        return 1;
+    }
+
+    setenv("MG_GAL_ENGINE", "dummy", 0);
+    setenv("MG_IAL_ENGINE", "dummy", 0);
+    setenv("MG_DEFAULTMODE", BENCH_MODE, 0);
+
+    if (InitGUI(argc, argv) != 0) {
+        fprintf(stderr, "piecebench: can not initialize MiniGUI.\n");
+        return 1;
+    }
+
+#ifdef _MGRM_PROCESSES
+    JoinLayer(NAME_DEF_LAYER, "piecebench", 0, 0);
+#endif
+
+    ncsInitialize();
+    ncs4TouchInitialize();
+    mGEffInit();
+    MGNCS_INIT_CLASS(mBenchTableView);
+    MGNCS_INIT_CLASS(mBenchVTableView);
+
+    s_mainHwnd = ((mWidget*)ncsCreateMainWindow(NCSCTRL_MAINWND, "piecebench",
+            WS_VISIBLE, WS_EX_NONE, 1,
+            0, 0, BENCH_W, BENCH_H,
+            HWND_DESKTOP,
+            0, 0, NULL, NULL, NULL, 0))->hwnd;
+
+    printf("%-12s %6s %8s %8s %8s %8s %8s %8s %8s %8s %12s\n",
+            "scenario", "frames", "first", "mean", "p50", "p90", "p99", "max",
+            "memdcs", "pieces", "pixels/frm");
+
+    for (i = 0; i < TABLESIZE(s_scenarios); ++i) {
+        BENCH_STATS stats;
+
+        if (any && !selected[i])
+            continue;
+        if (!s_runScenario(&s_scenarios[i], nr_frames, &stats)) {
+            ret = 1;
+            continue;
+        }
+        s_report(&stats);
+        free(stats.times);
+    }
+
+    DestroyMainWindow(s_mainHwnd);
+    MainWindowThreadCleanup(s_mainHwnd);
+
+    mGEffDeinit();
+    ncs4TouchUninitialize();
+    ncsUninitialize();
+
+    TerminateGUI(ret);
+    return ret;
+}
@@ -51,7 +51,14 @@ typedef struct _mContainerCtrlClass mContainerCtrlClass;
 typedef struct _mContainerCtrlRenderer mContainerCtrlRenderer;
 
 #define mContainerCtrlHeader(clsName)  \
-    mWidgetHeader(clsName)
+    mWidgetHeader(clsName)              \
+    DWORD frameInterval;                \
+    DWORD lastPaintTime;                \
+    DWORD paintDeadline;                \
+    BOOL paintScheduled;                \
+    BOOL paintErase;                    \
+    int deferredPaints;                 \
+    DWORD missedFrames;
 
 struct _mContainerCtrl
 {
@@ -77,9 +84,16 @@ struct _mContainerCtrlRenderer
 
 MGNCS_EXPORT extern mContainerCtrlClass g_stmContainerCtrlCls;
 
+/* default paint interval of NCSP_CTNRCTRL_FRAME_INTERVAL, in ms */
+#define CTNRCTRL_DEFAULT_FRAME_INTERVAL 16
+
 enum mContainerCtrlProp
 {
-    NCSP_CTNRCTRL_MAX = NCSP_WIDGET_MAX + 1
+    /* min ms between two paints driven by PanelPiece_update, 0 to paint at once */
+    NCSP_CTNRCTRL_FRAME_INTERVAL = NCSP_WIDGET_MAX + 1,
+    /* read only, scheduled paints that landed a frame or more late */
+    NCSP_CTNRCTRL_MISSED_FRAMES,
+    NCSP_CTNRCTRL_MAX
 };
 
 #define NCSS_CTNRCTRL_SHIFT NCSS_WIDGET_SHIFT
@@ -89,6 +103,10 @@ enum mContainerCtrlNotify
     NCSN_CTNRCTRL_MAX = NCSN_WIDGET_MAX + 1
 };
 
+/* paints the invalid region of self on the next frame boundary,
+ * several calls within one frame interval result in a single paint */
+MTOUCH_EXPORT void ContainerCtrl_schedulePaint(mContainerCtrl *self, BOOL fErase);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
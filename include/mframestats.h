@@ -0,0 +1,104 @@
+/*
+ * \file mframestats.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+#ifndef _MGNCS_FRAMESTATS_H
+#define _MGNCS_FRAMESTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Frame statistics of the containers, off until enabled by
+ * ncs4TouchEnableFrameStats() or by setting NCS4TOUCH_FRAMESTATS=1 in the
+ * environment before ncs4TouchInitialize(). A frame is one paint of a
+ * mContainerCtrl; its time is split in the time spent blitting children
+ * surfaces and layers onto their parents (composite) and the rest (paint).
+ */
+
+#define FRAMESTATS_NR_BUCKETS       12
+/* frame budget used unless ncs4TouchSetFrameBudget() is called, in ms */
+#define FRAMESTATS_DEFAULT_BUDGET   16
+
+typedef struct _FRAME_STATS {
+    unsigned int nr_frames;
+    /* frames per frame time bucket, bucket i holds the frames faster than
+     * bucket_limits[i] ms and not faster than the previous limit */
+    unsigned int histogram[FRAMESTATS_NR_BUCKETS];
+    unsigned int bucket_limits[FRAMESTATS_NR_BUCKETS];
+    double total_ms;            /* sum of the frame times */
+    double paint_ms;            /* part of total_ms spent painting pieces */
+    double composite_ms;        /* part of total_ms spent blitting layers */
+    double max_ms;              /* slowest frame */
+    double elapsed_ms;          /* from the first frame to the last one */
+    unsigned int budget_ms;
+    unsigned int over_budget;   /* frames slower than budget_ms */
+    double pixels;              /* invalidated area of all the frames */
+    unsigned int last_pixels;   /* invalidated area of the last frame */
+    int nr_clocks;              /* frame clocks of top panels ticking */
+    int nr_animations;          /* piece property animations running */
+} FRAME_STATS;
+
+MTOUCH_EXPORT void ncs4TouchEnableFrameStats(BOOL enable);
+
+MTOUCH_EXPORT BOOL ncs4TouchFrameStatsEnabled(void);
+
+/* frames slower than budget ms are counted by over_budget */
+MTOUCH_EXPORT void ncs4TouchSetFrameBudget(unsigned int budget);
+
+/* returns FALSE if the statistics are off, stats is filled anyway */
+MTOUCH_EXPORT BOOL ncs4TouchGetFrameStats(FRAME_STATS* stats);
+
+MTOUCH_EXPORT void ncs4TouchResetFrameStats(void);
+
+/* hooks of the paint path, the times are in ms from FrameStats_now() */
+extern BOOL g_frameStatsEnabled;
+
+/* 0 when the statistics are off */
+extern double FrameStats_now(void);
+extern void FrameStats_endFrame(double start, unsigned int pixels);
+extern void FrameStats_endComposite(double start);
+extern void FrameStats_clockStarted(void);
+extern void FrameStats_clockStopped(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_FRAMESTATS_H */
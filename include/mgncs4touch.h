@@ -45,8 +45,17 @@
 #include "mtouchcomm.h"
 #include "mtouchrdr.h"
 #include "manimation.h"
+#include "msurfacepool.h"
+#include "mspatialindex.h"
+#include "mptrmap.h"
+#include "mobjpool.h"
+#include "mframestats.h"
+#include "mpainttrace.h"
 
 #include "mpieceitem.h"
+#include "mlayercache.h"
+#include "mwarp.h"
+#include "mpieceanim.h"
 #include "mitemiterator.h"
 #include "mlayout_manager.h"
 #include "mcenterhbox.h"
@@ -61,6 +70,8 @@
 #include "pieces/mlistitemiterator.h"
 #include "pieces/mabstractitemmanager.h"
 #include "pieces/mlistitemmanager.h"
+#include "pieces/marrayitemiterator.h"
+#include "pieces/marrayitemmanager.h"
 #include "pieces/mpanelpiece.h"
 #include "pieces/mscrollviewpiece.h"
 #include "pieces/mrotateswitchpiece.h"
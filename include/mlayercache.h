@@ -0,0 +1,111 @@
+/*
+ * \file mlayercache.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+#ifndef _MGNCS_LAYERCACHE_H
+#define _MGNCS_LAYERCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Retained layers: a child item with isEnableCache set keeps its piece
+ * rendered in an ARGB memdc (mPieceItem.cacheDC) and composites it instead
+ * of painting the piece again. Invalidations coming from under the item
+ * mark the dirty part of the layer, which is repainted before the next
+ * use.
+ *
+ * All the layers share one LRU list with a byte budget; when it is
+ * exceeded the least recently composited layers are dropped and will be
+ * rebuilt the next time they are painted. Layers may be nested, so this
+ * only happens between frames, in LayerCache_trim().
+ *
+ * A layer can also carry box filtered 1/2 and 1/4 copies of itself, built
+ * on demand for children drawn scaled down and dropped with the layer or
+ * as soon as it is repainted.
+ */
+
+#define LAYERCACHE_DEFAULT_BUDGET   (8 * 1024 * 1024)
+
+typedef struct _LAYERCACHE_STATS {
+    unsigned int hits;          /* layer composited as is */
+    unsigned int misses;        /* layer created or resized */
+    unsigned int repaints;      /* dirty layer repainted */
+    unsigned int evictions;     /* layer dropped for the budget */
+    unsigned int nr_layers;     /* layers currently alive */
+    size_t bytes;               /* memory held by the layers */
+    size_t budget;              /* max bytes of all the layers */
+} LAYERCACHE_STATS;
+
+/* the memdc of the item layer, (re)created with the piece size if needed;
+ * a new layer is all dirty. */
+MTOUCH_EXPORT HDC LayerCache_acquire(mPieceItem* item, HDC ref_dc, int w, int h);
+
+/* delete the layer of the item, if any */
+MTOUCH_EXPORT void LayerCache_release(mPieceItem* item);
+
+/* the layer itself for level 0, else its copy downscaled 1 << level
+ * times, created from the previous level if needed; falls back to the
+ * closest level available */
+MTOUCH_EXPORT HDC LayerCache_getLevel(mPieceItem* item, int level);
+
+/* rc is in the coordinates of the piece, NULL for all of it */
+MTOUCH_EXPORT void LayerCache_markDirty(mPieceItem* item, const RECT* rc);
+
+/* the part of the layer to repaint before it is composited, which is
+ * then considered clean; FALSE if there is nothing to repaint. */
+MTOUCH_EXPORT BOOL LayerCache_takeDirtyRect(mPieceItem* item, RECT* rc);
+
+/* drop the coldest layers until the budget is met, never while painting */
+MTOUCH_EXPORT void LayerCache_trim(void);
+
+MTOUCH_EXPORT void LayerCache_setBudget(size_t budget);
+
+MTOUCH_EXPORT size_t LayerCache_getBudget(void);
+
+MTOUCH_EXPORT void LayerCache_getStats(LAYERCACHE_STATS* stats);
+
+MTOUCH_EXPORT void LayerCache_resetStats(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_LAYERCACHE_H */
+
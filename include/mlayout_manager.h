@@ -47,6 +47,9 @@ extern "C" {
 typedef struct _mLayoutManager mLayoutManager;
 typedef struct _mLayoutManagerClass mLayoutManagerClass;
 
+/* index for invalidate: items were only appended after the laid out ones */
+#define LAYOUT_INDEX_END    0x7FFFFFFF
+
 #define mLayoutManagerHeader(clss) \
     mObjectHeader(clss)
 
@@ -57,7 +60,9 @@ struct _mLayoutManager
 
 #define mLayoutManagerClassHeader(clss, superCls) \
     mObjectClassHeader(clss, superCls) \
-    void (*reLayout)(clss*, mItemIterator*, int, int);
+    void (*reLayout)(clss*, mItemIterator*, int, int); \
+    /* the items from index on have to be laid out again, 0 for all */ \
+    void (*invalidate)(clss*, int index);
 
 struct _mLayoutManagerClass
 {
@@ -47,9 +47,23 @@ extern "C" {
 typedef struct _mLineVBox mLineVBox;
 typedef struct _mLineVBoxClass mLineVBoxClass;
 
+/*
+ * The box caches the height and the y of every row it laid out, a pass
+ * only walks the rows from the first invalidated index on; rows before
+ * it are skipped without calling getRect. Call invalidate when a row
+ * changes its height or rows are inserted or removed in the middle, the
+ * panel does it for addContentToLayout/delContent and reLayout.
+ * indexAtY/yOfIndex answer from the last pass.
+ */
 #define mLineVBoxHeader(clss)  \
     mLayoutManagerHeader(clss) \
-    int gap;
+    int gap; \
+    int *heights; \
+    int *offsets;   /* y of every row, offsets[nr_rows] is the end */ \
+    int *widths; \
+    int nr_rows; \
+    int max_rows; \
+    int dirtyFrom;
 
 struct _mLineVBox
 {
@@ -59,7 +73,10 @@ struct _mLineVBox
 #define mLineVBoxClassHeader(clss, superCls) \
     mLayoutManagerClassHeader(clss, superCls)\
     void (*setGap)(clss*, int); \
-    void (*getLayoutRect)(clss*, mItemIterator* , RECT* );
+    void (*getLayoutRect)(clss*, mItemIterator* , RECT* ); \
+    int (*indexAtY)(clss*, int y); \
+    int (*yOfIndex)(clss*, int index); \
+    int (*getRowCount)(clss*);
 
 struct _mLineVBoxClass
 {
@@ -0,0 +1,94 @@
+/*
+ * \file mobjpool.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+
+#ifndef _MGNCS_OBJPOOL_H
+#define _MGNCS_OBJPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Object pools: small objects are carved out of page sized slabs, one
+ * free list per 16 bytes size class, so that the items created and
+ * deleted by the thousand when contents are reloaded reuse the same
+ * memory instead of fragmenting the heap. A class keeps one empty slab
+ * around, more are given back.
+ *
+ * ObjPool_free() and POOL_DELETE() accept memory from malloc() too, so
+ * an object may be created with NEW() by a subclass overriding a
+ * factory method and still be deleted by code using the pool.
+ * Never hand pool memory to free() or DELETE().
+ */
+
+/* larger objects come from calloc() */
+#define OBJPOOL_MAX_SIZE    512
+
+typedef struct _OBJPOOL_STATS {
+    unsigned int live;          /* objects allocated from the slabs */
+    unsigned int peak;          /* max of live */
+    unsigned int allocs;        /* pool allocations so far */
+    unsigned int nr_slabs;      /* slabs currently held */
+    size_t bytes;               /* memory held by the slabs */
+} OBJPOOL_STATS;
+
+/* zeroed memory for an object of size bytes */
+MTOUCH_EXPORT void* ObjPool_alloc(size_t size);
+
+MTOUCH_EXPORT void ObjPool_free(void* ptr);
+
+/* same as newObject() and deleteObject() with the memory of the pool */
+MTOUCH_EXPORT mObject* ObjPool_newObject(mObjectClass* _class);
+
+MTOUCH_EXPORT void ObjPool_deleteObject(mObject* obj);
+
+MTOUCH_EXPORT void ObjPool_getStats(OBJPOOL_STATS* stats);
+
+#define POOL_NEW(clss) \
+    ((clss*)ObjPool_newObject((mObjectClass*)(void*)(&(Class(clss)))))
+
+#define POOL_DELETE(obj) \
+    ObjPool_deleteObject((mObject*)(obj))
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_OBJPOOL_H */
@@ -0,0 +1,96 @@
+/*
+ * \file mpainttrace.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+#ifndef _MGNCS_PAINTTRACE_H
+#define _MGNCS_PAINTTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Paint tracer: when started, every piece paint made through
+ * PAINTTRACE_PAINT() records its class name, start time and duration in a
+ * ring buffer, which PaintTrace_dump() writes as Chrome trace_event JSON
+ * (open it in chrome://tracing or Perfetto). Only the latest events are
+ * kept once the ring wraps.
+ *
+ * Setting NCS4TOUCH_PAINTTRACE=<file> in the environment starts the
+ * tracer in ncs4TouchInitialize() and dumps it to <file> in
+ * ncs4TouchUninitialize().
+ */
+
+/* ring size used when PaintTrace_start() is given 0, in events */
+#define PAINTTRACE_DEFAULT_EVENTS   65536
+
+/* nr_events is rounded up to a power of 2 */
+MTOUCH_EXPORT BOOL PaintTrace_start(int nr_events);
+
+/* stops recording, the events are kept for PaintTrace_dump() */
+MTOUCH_EXPORT void PaintTrace_stop(void);
+
+MTOUCH_EXPORT void PaintTrace_clear(void);
+
+MTOUCH_EXPORT BOOL PaintTrace_dump(const char* path);
+
+/* recorded paint of piece, call PAINTTRACE_PAINT() instead */
+MTOUCH_EXPORT void PaintTrace_paint(mHotPiece* piece, HDC hdc, mObject* owner, DWORD add_data);
+
+extern BOOL g_paintTraceOn;
+
+#ifdef __GNUC__
+#define PAINTTRACE_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define PAINTTRACE_UNLIKELY(x) (x)
+#endif
+
+/* _c(piece)->paint(), recorded while the tracer runs */
+#define PAINTTRACE_PAINT(piece, hdc, owner, add_data) \
+    do { \
+        if (PAINTTRACE_UNLIKELY(g_paintTraceOn)) \
+            PaintTrace_paint((mHotPiece*)(piece), (hdc), (mObject*)(owner), (DWORD)(add_data)); \
+        else \
+            _c(piece)->paint((piece), (hdc), (owner), (add_data)); \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_PAINTTRACE_H */
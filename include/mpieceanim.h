@@ -0,0 +1,90 @@
+/*
+ * \file mpieceanim.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+
+#ifndef _MGNCS_PIECEANIM_H
+#define _MGNCS_PIECEANIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Piece animation tracks: the property animations of panel children
+ * (position, scale, rotation, alpha) live in one table of parallel
+ * arrays. The mGEff animation handed out for a track only reports the
+ * eased progress; the values are written into the mPieceItem fields for
+ * all the tracks at once in PieceAnim_flush(), which the frame clock of
+ * the top panels runs on every tick, and each panel is invalidated once
+ * with the bound of what moved in it. A panel class that overrides
+ * movePiece, scalePiece, rotatePiece or setPieceAlpha gets the values of
+ * that property through its setter instead.
+ *
+ * A track ends with its animation, or when a new one is created for the
+ * same item and property, or when the item is deleted.
+ */
+
+enum {
+    PIECEANIM_MOVE = 1,     /* item x, y */
+    PIECEANIM_SCALE,        /* item wscalefactor, hscalefactor */
+    PIECEANIM_ROTATE,       /* item normalVector.angle */
+    PIECEANIM_ALPHA,        /* item alpha */
+};
+
+/* an animation of the property of item, a child of panel, from from[]
+ * to to[]; the second value is only used by move and scale */
+MTOUCH_EXPORT MGEFF_ANIMATION PieceAnim_create(mHotPiece* panel, mPieceItem* item,
+        int prop, const float from[2], const float to[2],
+        int duration, enum EffMotionType curve);
+
+/* write the pending values of all the tracks and invalidate what they
+ * changed; direct changes of the same properties must flush first. */
+MTOUCH_EXPORT void PieceAnim_flush(void);
+
+/* end the tracks of item, it is going away */
+MTOUCH_EXPORT void PieceAnim_dropItem(mPieceItem* item);
+
+/* number of live tracks */
+MTOUCH_EXPORT int PieceAnim_getTrackCount(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_PIECEANIM_H */
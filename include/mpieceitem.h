@@ -44,6 +44,9 @@
 extern "C" {
 #endif
 
+/* downscaled copies (1/2, 1/4) kept with a retained layer, see mlayercache.h */
+#define LAYERCACHE_MAX_LEVEL    2
+
 typedef struct _mNormalVerctor
 {
     float angle;
@@ -68,7 +71,13 @@ typedef struct _mPieceItem mPieceItem;
     HDC cacheDC; \
     BOOL isEnableCache; \
     BOOL underLayout;\
-    int type;
+    int type; \
+    list_t cacheList; \
+    size_t cacheBytes; \
+    RECT cacheDirtyRect; \
+    HDC cacheLevels[LAYERCACHE_MAX_LEVEL]; \
+    RECT visibleRect; \
+    int index;
 
 #define mPieceItemClassHeader(clss, superCls) \
     mObjectClassHeader(clss, superCls)  \
@@ -0,0 +1,75 @@
+/*
+ * \file mptrmap.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+#ifndef _MGNCS_PTRMAP_H
+#define _MGNCS_PTRMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A small open addressing hash map from a pointer to a pointer, used to
+ * find the item holding a piece without walking the item list.
+ * NULL is neither a valid key nor a valid value.
+ */
+
+typedef struct _PTR_MAP PTR_MAP;
+
+MTOUCH_EXPORT PTR_MAP* PtrMap_create(void);
+
+MTOUCH_EXPORT void PtrMap_destroy(PTR_MAP* map);
+
+MTOUCH_EXPORT void* PtrMap_get(PTR_MAP* map, const void* key);
+
+/* add or replace, FALSE if out of memory */
+MTOUCH_EXPORT BOOL PtrMap_put(PTR_MAP* map, const void* key, void* value);
+
+MTOUCH_EXPORT void PtrMap_remove(PTR_MAP* map, const void* key);
+
+MTOUCH_EXPORT void PtrMap_clear(PTR_MAP* map);
+
+MTOUCH_EXPORT int PtrMap_count(PTR_MAP* map);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_PTRMAP_H */
+
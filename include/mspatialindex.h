@@ -0,0 +1,92 @@
+/*
+ * \file mspatialindex.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+#ifndef _MGNCS_SPATIALINDEX_H
+#define _MGNCS_SPATIALINDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A spatial index buckets the children of a panel into a uniform grid of
+ * cells, so a point lookup only looks at the few children overlapping the
+ * cell under the point instead of walking all of them.
+ *
+ * Every entry carries an order (its z-order in the panel), a cell keeps
+ * its entries sorted by it, and the lookup tries the topmost first.
+ */
+
+#define SPATIALINDEX_DEFAULT_CELL   64
+
+typedef struct _SPATIAL_INDEX SPATIAL_INDEX;
+
+/* return TRUE if data really contains (x, y) */
+typedef BOOL (*SPATIALINDEX_HIT_CB)(void *data, int x, int y, void *ctx);
+
+MTOUCH_EXPORT SPATIAL_INDEX* SpatialIndex_create(int cell_size);
+
+MTOUCH_EXPORT void SpatialIndex_destroy(SPATIAL_INDEX* index);
+
+/* drop all entries and cover the area (0, 0, w, h) */
+MTOUCH_EXPORT void SpatialIndex_reset(SPATIAL_INDEX* index, int w, int h);
+
+/* mark the index stale, the owner rebuilds it before the next lookup */
+MTOUCH_EXPORT void SpatialIndex_invalidate(SPATIAL_INDEX* index);
+
+MTOUCH_EXPORT BOOL SpatialIndex_isValid(SPATIAL_INDEX* index);
+
+MTOUCH_EXPORT BOOL SpatialIndex_insert(SPATIAL_INDEX* index, void *data, int order, const RECT *rc);
+
+MTOUCH_EXPORT void SpatialIndex_remove(SPATIAL_INDEX* index, void *data, const RECT *rc);
+
+/* move data from old_rc to new_rc, keeping its order */
+MTOUCH_EXPORT BOOL SpatialIndex_move(SPATIAL_INDEX* index, void *data,
+        const RECT *old_rc, const RECT *new_rc);
+
+/* the topmost entry under (x, y) accepted by hit */
+MTOUCH_EXPORT void* SpatialIndex_query(SPATIAL_INDEX* index, int x, int y,
+        SPATIALINDEX_HIT_CB hit, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_SPATIALINDEX_H */
+
@@ -0,0 +1,95 @@
+/*
+ * \file msurfacepool.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+#ifndef _MGNCS_SURFACEPOOL_H
+#define _MGNCS_SURFACEPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A surface pool recycles the temporary memory DCs used while compositing
+ * pieces. Surfaces are keyed by (width, height, pixel format); idle ones
+ * are kept until the byte budget is exceeded, then the least recently
+ * released surface is deleted first.
+ */
+
+#define SURFACEPOOL_DEFAULT_BUDGET  (4 * 1024 * 1024)
+
+typedef struct _SURFACE_POOL SURFACE_POOL;
+
+typedef struct _SURFACEPOOL_STATS {
+    unsigned int hits;          /* get() served from an idle surface */
+    unsigned int misses;        /* get() had to create a new memdc */
+    unsigned int evictions;     /* idle surfaces deleted for the budget */
+    unsigned int nr_idle;       /* idle surfaces currently cached */
+    unsigned int nr_busy;       /* surfaces handed out, not yet released */
+    size_t idle_bytes;          /* memory held by the idle surfaces */
+    size_t budget;              /* max bytes of idle surfaces */
+} SURFACEPOOL_STATS;
+
+MTOUCH_EXPORT SURFACE_POOL* SurfacePool_create(size_t budget);
+
+MTOUCH_EXPORT void SurfacePool_destroy(SURFACE_POOL* pool);
+
+/* Return a memdc compatible with ref_dc of the given size. Its content is
+ * undefined; release it with SurfacePool_put(), never with DeleteMemDC(). */
+MTOUCH_EXPORT HDC SurfacePool_get(SURFACE_POOL* pool, HDC ref_dc, int w, int h);
+
+/* Same as SurfacePool_get(), but always a 32 bit ARGB memdc blending per
+ * pixel, whatever the format of the destination. */
+MTOUCH_EXPORT HDC SurfacePool_getARGB(SURFACE_POOL* pool, int w, int h);
+
+MTOUCH_EXPORT void SurfacePool_put(SURFACE_POOL* pool, HDC memdc);
+
+MTOUCH_EXPORT void SurfacePool_setBudget(SURFACE_POOL* pool, size_t budget);
+
+/* delete all idle surfaces */
+MTOUCH_EXPORT void SurfacePool_clear(SURFACE_POOL* pool);
+
+MTOUCH_EXPORT void SurfacePool_getStats(SURFACE_POOL* pool, SURFACEPOOL_STATS* stats);
+
+MTOUCH_EXPORT void SurfacePool_resetStats(SURFACE_POOL* pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_SURFACEPOOL_H */
@@ -0,0 +1,74 @@
+/*
+ * \file mwarp.h
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+
+
+#ifndef _MGNCS_WARP_H
+#define _MGNCS_WARP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Perspective warp of a card rotating around one of its center axes, used
+ * by the rotate effects of mPanelPiece. The transform is set up once per
+ * call with 16.16 fixed point math, then every destination scanline
+ * (column for the vertical axis) gets precomputed source coordinates and
+ * steps, so the pixel loops only add integers. 32 bit and 16 bit memdcs
+ * are supported; 32 bit sources with an alpha channel are blended.
+ */
+
+enum {
+    WARP_AXIS_X,    /* flip around the horizontal center line */
+    WARP_AXIS_Y,    /* flip around the vertical center line */
+};
+
+/* bilinear filtering instead of nearest sampling, 32 bit only */
+#define WARP_FLAG_BILINEAR  0x0001
+
+/* Draw src over dst, both the same depth, rotated by angle degrees
+ * (0 to 180) around axis. Only the clip box of dst is written. */
+MTOUCH_EXPORT BOOL Warp_rotate(HDC dst, HDC src, float angle, int axis, DWORD flags);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MGNCS_WARP_H */
+
@@ -48,6 +48,29 @@ extern "C" {
  * typedef struct _mAbstractItemManager mAbstractItemManager;
  */
 
+/*
+ * Position of a walk over a manager that needs no iterator object, keep
+ * it on the stack and walk with FOR_EACH_ITEM/FOR_EACH_ITEM_REVERSE.
+ * A cursor goes one way only. The current item may be removed from the
+ * list and array managers while walking, no item may be added.
+ */
+typedef struct _ITEM_CURSOR {
+    void *pos;      /* manager specific, NULL before the first item */
+    void *next;     /* prefetched neighbour of pos */
+    int index;      /* last position walked, -1 before the first item */
+} ITEM_CURSOR;
+
+#define ItemCursor_init(cursor) \
+    ((cursor)->pos = (cursor)->next = NULL, (cursor)->index = -1)
+
+#define FOR_EACH_ITEM(manager, cursor, item) \
+    for (ItemCursor_init(&(cursor)); \
+            ((item) = _c(manager)->cursorNext((manager), &(cursor))) != NULL; )
+
+#define FOR_EACH_ITEM_REVERSE(manager, cursor, item) \
+    for (ItemCursor_init(&(cursor)); \
+            ((item) = _c(manager)->cursorPrev((manager), &(cursor))) != NULL; )
+
 #define mAbstractItemManagerHeader(clss) \
     mObjectHeader(clss)
 
@@ -56,7 +79,9 @@ extern "C" {
     int  (*addItem)(clss*, mPieceItem*);  \
     void (*removeItem)(clss*, mPieceItem*);  \
     void (*clear)(clss*);   \
-    mItemIterator* (*createItemIterator)(clss*);
+    mItemIterator* (*createItemIterator)(clss*); \
+    mPieceItem* (*cursorNext)(clss*, ITEM_CURSOR*); \
+    mPieceItem* (*cursorPrev)(clss*, ITEM_CURSOR*);
 
 struct _mAbstractItemManager
 {   
@@ -0,0 +1,93 @@
+/*
+ * \file 
+ * \author FMSoft
+ * \date 
+ *
+ \verbatim
+
+    This file is part of mGNCS4Touch, one of MiniGUI components.
+
+    Copyright (C) 2008-2018 FMSoft (http://www.fmsoft.cn).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Or,
+
+    As this program is a library, any link to this program must follow
+    GNU General Public License version 3 (GPLv3). If you cannot accept
+    GPLv3, you need to be licensed from FMSoft.
+
+    If you have got a commercial license of this program, please use it
+    under the terms and conditions of the commercial license.
+
+    For more information about the commercial license, please refer to
+    <http://www.minigui.com/en/about/licensing-policy/>.
+
+ \endverbatim
+*/
+#ifndef  MARRAYITEMMANAGER_INC
+#define  MARRAYITEMMANAGER_INC
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mabstractitemmanager.h"
+
+/*
+ * Item manager keeping the items in a growing array of pointers, return
+ * it from createItemManager of a panel subclass. Each item records its
+ * slot in item->index, so removeItem only clears the slot; the holes are
+ * squeezed out the next time items are added to a full array. A count of
+ * the items per slot gives itemAt/indexOf the position of an item
+ * without the holes in O(log n). Iterators skip the holes, items may be
+ * removed and looked up while iterating but not added.
+ */
+
+typedef struct _mArrayItemManagerClass mArrayItemManagerClass;
+typedef struct _mArrayItemManager mArrayItemManager;
+
+#define mArrayItemManagerHeader(clss) \
+    mAbstractItemManagerHeader(clss)    \
+    mPieceItem **items; \
+    int nr_slots;   /* slots in use, holes included */ \
+    int max_slots; \
+    int nr_items; \
+    int *counts;    /* fenwick tree of the items per slot */
+
+#define mArrayItemManagerClassHeader(clss, superCls) \
+    mAbstractItemManagerClassHeader(clss, superCls) \
+    mPieceItem* (*itemAt)(clss*, int index); \
+    int (*indexOf)(clss*, mPieceItem*); \
+    int (*getCount)(clss*);
+
+struct _mArrayItemManager
+{   
+    mArrayItemManagerHeader(mArrayItemManager)
+};
+
+struct _mArrayItemManagerClass
+{   
+    mArrayItemManagerClassHeader(mArrayItemManager, mAbstractItemManager)
+};
+
+MGNCS_EXPORT extern mArrayItemManagerClass g_stmArrayItemManagerCls;
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif   /* ----- #ifndef MARRAYITEMMANAGER_INC  ----- */
+
@@ -44,18 +44,43 @@
 extern "C" {
 #endif
 
+/*
+ * Besides the itemList/child lists walked by the iterators, the manager
+ * keeps the groups and the children of every group in arrays sorted by
+ * itemCmp, so lookups and ordered inserts are binary searches. The key
+ * of an item is cached when it is added: remove and add the item again
+ * after changing its key, and set itemCmp before adding any item.
+ * A child belongs to the group keyed by the first char of its key.
+ */
+
 typedef int (*ITEM_CMP)(const char* s1, const char* s2);
 typedef struct _mGroupItemManagerClass mGroupItemManagerClass;
 typedef struct _mGroupItemManager mGroupItemManager;
 
+typedef struct _GROUP_KEY {
+    const char* key;
+    mGroupPieceItem* item;
+} GROUP_KEY;
+
+typedef struct _GROUP_SLOT {
+    GROUP_KEY group;    /* must be the first member */
+    GROUP_KEY* children;
+    int nr_children;
+    int max_children;
+} GROUP_SLOT;
+
 #define mGroupItemManagerHeader(clss) \
     mAbstractItemManagerHeader(clss) \
     list_t itemList; \
-    ITEM_CMP itemCmp;
+    ITEM_CMP itemCmp; \
+    GROUP_SLOT* groups; \
+    int nr_groups; \
+    int max_groups;
 
 #define mGroupItemManagerClassHeader(clss, superCls) \
     mAbstractItemManagerClassHeader(clss, superCls) \
     BOOL (*addGroupItem)(clss*,  mGroupPieceItem*, BOOL); \
+    int (*addGroupItems)(clss*, mGroupPieceItem**, int, BOOL); \
     BOOL (*removeGroupItem)(clss*, const char*, BOOL); \
     mGroupPieceItem* (*searchGroupItem)(clss*, const char*, BOOL); \
     mGroupPieceItem* (*searchGreaterGroupItem)(clss*, const char*, BOOL); \
@@ -96,9 +96,23 @@ typedef struct _POINTF
 enum mPanelPieceProp
 {
     NCSP_PANEL_CLIPRECT = USER_PIECE_PROP_BEGIN + 200,
+    /* byte budget of the idle surfaces kept by the top panel */
+    NCSP_PANEL_SURFACEPOOL_BUDGET,
+    /* cell size of the grid used to hit test children, 0 to disable */
+    NCSP_PANEL_SPATIALINDEX,
+    /* resample children scaled below 1/2 from downscaled copies, TRUE by default */
+    NCSP_PANEL_SCALE_MIPMAP,
+    /* filter rotated children bilinearly, FALSE by default */
+    NCSP_PANEL_ROTATE_BILINEAR,
 };
 
 
+/* max disjoint damage rects a top panel accumulates between two paints */
+#define PANEL_MAX_DAMAGE_RECTS 8
+
+/* event handlers sorted by message, see appendEventHandler */
+typedef struct _PANEL_EVENT_HANDLER PANEL_EVENT_HANDLER;
+
 typedef struct _mPanelPiece mPanelPiece;
 typedef struct _mPanelPieceClass mPanelPieceClass;
 
@@ -107,17 +121,30 @@ typedef struct _mPanelPieceClass mPanelPieceClass;
     BOOL isTopPanel;            \
     BOOL shouldResetPaintMode;   \
     mAbstractItemManager *itemManager; \
-    list_t eventHandlers;      \
+    PANEL_EVENT_HANDLER *eventHandlers; \
+    int nr_eventHandlers;      \
+    int max_eventHandlers;     \
+    DWORD eventMask;           \
     mShapeTransRoundPiece* bkgndPiece;     \
     mHotPiece* hovering_piece; \
     mLayoutManager *layout;    \
+    BOOL layoutDirty;          \
     mWidget* owner;            \
     BOOL update_flag;          \
     MGEFF_ANIMATION update_anim;    \
+    DWORD clockDeadline;       \
+    int clockIdleTicks;        \
     MGEFF_ANIMATION animgrp;        \
     DWORD addData; \
     RECT clipRect; \
-    RECT invalidRect; 
+    RECT invalidRect; \
+    SURFACE_POOL *surfacePool; \
+    int nr_damage_rects; \
+    RECT damageRects[PANEL_MAX_DAMAGE_RECTS]; \
+    SPATIAL_INDEX *spatialIndex; \
+    PTR_MAP *itemMap; \
+    BOOL scaleMipmap; \
+    BOOL rotateBilinear;
 
 struct _mPanelPiece
 {
@@ -160,7 +187,8 @@ typedef int (*NCS_PIECE_EVENT_HANDLER)(mHotPiece *, int message, WPARAM, LPARAM,
     void (*animationAsyncRun)(clss *self, MGEFF_ANIMATION, int keepalive); \
     mShapeTransRoundPiece* (*getBkgndPiece)(clss *); \
     void (*invalidatePiece)(clss *, mHotPiece *piece, const RECT *rc, BOOL reserveCache); \
-    void (*setBkgndPiece)(clss *, mShapeTransRoundPiece*);
+    void (*setBkgndPiece)(clss *, mShapeTransRoundPiece*); \
+    BOOL (*getOpaqueRect)(clss *, RECT*);
 
 struct _mPanelPieceClass
 {
@@ -173,7 +201,17 @@ MGNCS_EXPORT extern mPanelPieceClass g_stmPanelPieceCls;
 // global functions
 extern void PanelPiece_invalidatePiece(mHotPiece *piece, const RECT *rc);
 extern void PanelPiece_update(mHotPiece *piece, BOOL fErase);
+/* keeps the frame clock of the top panel of piece ticking for at least
+ * duration ms, the clock stops by itself once nothing is invalidated */
+extern void PanelPiece_runFrameClock(mHotPiece *piece, int duration);
 extern mPanelPiece *PanelPiece_getTopPanel(mHotPiece *self);
+extern SURFACE_POOL *PanelPiece_getSurfacePool(mHotPiece *piece);
+extern void PanelPiece_addDamageRect(mPanelPiece *topPanel, const RECT *rc);
+/* call it after changing the x/y of a child item without movePiece */
+extern void PanelPiece_invalidateSpatialIndex(mPanelPiece *self);
+/* runs the layout pass deferred by addContentToLayout/delContent, call it
+ * before reading the x/y of laid out items outside paint and hit tests */
+extern void PanelPiece_flushLayout(mPanelPiece *self);
 
 #define PanelPiece_isTopPanel(self) \
     ( ( (self)->parent == NULL ) && ( (self)->owner != NULL ) )
@@ -97,6 +97,30 @@ enum mTableViewItemPieceType {
 
 #define NCS_TABLEVIEW_SEPARATOR_DEFAULTCOLOR 0xffced3d6
 
+/* extra pixels materialized above and below the viewport in virtualized mode */
+#define NCS_TABLEVIEW_OVERSCAN      60
+
+/* a section of a virtualized table, in tablePanel coordinates. rowHeights
+ * holds estimates until a row is measured, rowOffsets (rows + 1 entries,
+ * separators included) is valid below dirtyFrom. */
+typedef struct _TABLEVIEW_SECTION {
+    int top;
+    int headerHeight;
+    int rows;
+    int* rowHeights;
+    int* rowOffsets;
+    unsigned char* measured;
+    int dirtyFrom;
+} TABLEVIEW_SECTION;
+
+/* a materialized row of a virtualized table, row is -1 for the section header */
+typedef struct _TABLEVIEW_ROW {
+    mHotPiece* piece;
+    mIndexPath indexpath;
+    int reuseType;
+    mHotPiece* defaultRow;  /* user piece built by createDefaultRow */
+} TABLEVIEW_ROW;
+
 #define mTableViewPieceHeader(clss) \
 	mScrollViewPieceHeader(clss) \
     mTableViewItemPiece* focusPiece; \
@@ -107,7 +131,23 @@ enum mTableViewItemPieceType {
     mPanelPiece* tablePanel; \
     DWORD separatorColor;\
     int rowHeight;\
-    int separatorStyle; 
+    int separatorStyle; \
+    /* virtualized mode, see setVirtualized */ \
+    BOOL virtualized; \
+    int overscan; \
+    int contentHeight; \
+    TABLEVIEW_SECTION* sections; \
+    int nr_sections; \
+    int sectionsDirtyFrom; \
+    TABLEVIEW_ROW* rows; \
+    int nr_rows; \
+    int max_rows; \
+    TABLEVIEW_ROW* reuseQueue; \
+    int nr_reuse; \
+    int max_reuse; \
+    TABLEVIEW_ROW* dequeued; \
+    int nr_dequeued; \
+    int max_dequeued;
 
 struct _mTableViewPiece
 {
@@ -133,6 +173,9 @@ struct _mTableViewPiece
     void (*rectForSection)(clss* self, int section, RECT* rect);\
     void (*setSeparatorStyle)(clss* self, enum mTableViewSeparatorStyle);\
     void (*setSeparatorColor)(clss* self, DWORD color);\
+    /* only materialize the rows around the viewport, call before reloadData. */ \
+    void (*setVirtualized)(clss* self, BOOL virtualized);\
+    mTableViewItemPiece* (*dequeueReusableRow)(clss* self, int reuseType);\
     /* public interface. */ \
     BOOL (*willSelectRowAtIndexPath)(clss* self, const mIndexPath* indexpath);\
     void (*onCommitInsertRowAtIndexPath)(clss* self, const mIndexPath* indexpath); \
@@ -142,7 +185,12 @@ struct _mTableViewPiece
     int (*numberOfRowsInSection)(clss* self, int section);\
     const char* (*titleForSection)(clss* self, int section); \
     const char* (*indexForSection)(clss* self, int section);\
-    void (*rowDidSelectAtIndexPath)(clss* self, const mIndexPath* indexpath);
+    void (*rowDidSelectAtIndexPath)(clss* self, const mIndexPath* indexpath);\
+    int (*reuseTypeForRow)(clss* self, const mIndexPath* indexpath);\
+    /* row heights of the virtualized mode, an estimate <= 0 asks for the exact height up front. \
+     * without an override and a rowHeight, a row takes the height of its piece. */ \
+    int (*heightForRowAtIndexPath)(clss* self, const mIndexPath* indexpath);\
+    int (*estimatedHeightForRow)(clss* self, const mIndexPath* indexpath);
     
 
 struct _mTableViewPieceClass
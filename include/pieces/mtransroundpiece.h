@@ -129,7 +129,8 @@ struct _mShapeTransRoundPiece
     mStaticPieceClassHeader(clss, superCls) \
     HBRUSH (*getBrush) (clss*); \
     HBRUSH (*getBorderBrush)(clss*); \
-    int (*setGradientFillColors) (clss*, ARGB *, int);
+    int (*setGradientFillColors) (clss*, ARGB *, int); \
+    BOOL (*getOpaqueRect)(clss*, RECT*);
 
 struct _mShapeTransRoundPieceClass
 {   
@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <time.h>
 
 #include <minigui/common.h>
 #include <minigui/minigui.h>
@@ -43,79 +44,225 @@
 
 #include "mgncs4touch.h"
 
-static void mContainerCtrl_setBody(mContainerCtrl* self, mHotPiece* body)
+/* consecutive frames a late paint may yield to pending input */
+#define MAX_DEFERRED_PAINTS 2
+
+static DWORD s_now(void)
 {
-    self->body = (mObject*)body;
+    struct timespec ts;
 
-    assert(INSTANCEOF(body, mPanelPiece));
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (DWORD)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
 
-    // set owner for body
-    _c((mPanelPiece*)body)->setOwner((mPanelPiece*)body, (mWidget*)self);
+static void mContainerCtrl_construct(mContainerCtrl *self, DWORD addData)
+{
+    Class(mWidget).construct((mWidget*)self, addData);
 
-    return;
+    self->frameInterval = CTNRCTRL_DEFAULT_FRAME_INTERVAL;
+    self->lastPaintTime = s_now() - self->frameInterval;
+    self->paintDeadline = 0;
+    self->paintScheduled = FALSE;
+    self->paintErase = FALSE;
+    self->deferredPaints = 0;
+    self->missedFrames = 0;
+}
+
+static void mContainerCtrl_destroy(mContainerCtrl *self)
+{
+    if (self->paintScheduled) {
+        KillTimer(self->hwnd, (LINT)self);
+        self->paintScheduled = FALSE;
+    }
+
+    Class(mWidget).destroy((mWidget*)self);
+}
+
+static BOOL s_hasPendingInput(mContainerCtrl *self)
+{
+    MSG msg;
+    return PeekMessage(&msg, self->hwnd, MSG_FIRSTMOUSEMSG, MSG_LASTKEYMSG, PM_NOREMOVE);
+}
+
+static BOOL s_onPaintTimer(HWND hwnd, LINT id, DWORD tickCount);
+
+static void s_armPaintTimer(mContainerCtrl *self, DWORD delay)
+{
+    self->paintDeadline = s_now() + delay;
+    self->paintScheduled = TRUE;
+    /* timers count in 10ms */
+    SetTimerEx(self->hwnd, (LINT)self, delay > 10 ? (delay + 9) / 10 : 1, s_onPaintTimer);
+}
+
+static BOOL s_onPaintTimer(HWND hwnd, LINT id, DWORD tickCount)
+{
+    mContainerCtrl *self = (mContainerCtrl *)id;
+    DWORD late = s_now() - self->paintDeadline;
+
+    if ((int)late >= (int)self->frameInterval) {
+        self->missedFrames ++;
+        /* the frame is lost anyway, let the input queued meanwhile go first */
+        if (self->deferredPaints < MAX_DEFERRED_PAINTS && s_hasPendingInput(self)) {
+            self->deferredPaints ++;
+            s_armPaintTimer(self, self->frameInterval);
+            /* keep the re-armed timer, FALSE would kill it */
+            return TRUE;
+        }
+    }
+
+    /* done, returning FALSE kills the timer */
+    self->paintScheduled = FALSE;
+    UpdateInvalidRect(self->hwnd, self->paintErase);
+    return FALSE;
+}
+
+void ContainerCtrl_schedulePaint(mContainerCtrl *self, BOOL fErase)
+{
+    DWORD elapsed;
+
+    if (self->frameInterval == 0) {
+        UpdateInvalidRect(self->hwnd, fErase);
+        return;
+    }
+
+    if (self->paintScheduled) {
+        self->paintErase = self->paintErase || fErase;
+        return;
+    }
+
+    elapsed = s_now() - self->lastPaintTime;
+    if (elapsed >= self->frameInterval) {
+        UpdateInvalidRect(self->hwnd, fErase);
+        return;
+    }
+
+    self->paintErase = fErase;
+    s_armPaintTimer(self, self->frameInterval - elapsed);
 }
 
-#ifdef ENABLE_ANIM_FPS_TEST
-#include <sys/times.h>
-#include <unistd.h>
+static BOOL mContainerCtrl_setProperty(mContainerCtrl *self, int id, DWORD value)
+{
+    if (id >= NCSP_CTNRCTRL_MAX)
+        return FALSE;
 
-#define TCK_PER_SEC sysconf(_SC_CLK_TCK)
-#define ANIM_TICKS_MAX	(2 * TCK_PER_SEC)
+    switch (id) {
+        case NCSP_CTNRCTRL_FRAME_INTERVAL:
+            self->frameInterval = value;
+            return TRUE;
+        case NCSP_CTNRCTRL_MISSED_FRAMES:
+            return FALSE;
+    }
 
-volatile int anim_fps_test_status = 0; /* 0:ready, 1:running */
-static int anim_frames = 0;
-static clock_t anim_start_time = 0;
+    return Class(mWidget).setProperty((mWidget*)self, id, value);
+}
 
-static void anim_fps_test_tellspeed (int ticks)
+static DWORD mContainerCtrl_getProperty(mContainerCtrl *self, int id)
 {
-    unsigned int fps = (int) ( (double) anim_frames / (ticks / TCK_PER_SEC) );
+    if (id >= NCSP_CTNRCTRL_MAX)
+        return (DWORD)-1;
+
+    switch (id) {
+        case NCSP_CTNRCTRL_FRAME_INTERVAL:
+            return self->frameInterval;
+        case NCSP_CTNRCTRL_MISSED_FRAMES:
+            return self->missedFrames;
+    }
+
+    return Class(mWidget).getProperty((mWidget*)self, id);
+}
+
+static void mContainerCtrl_setBody(mContainerCtrl* self, mHotPiece* body)
+{
+    self->body = (mObject*)body;
+
+    assert(INSTANCEOF(body, mPanelPiece));
 
-    /* print result */
-    fprintf (stderr, "**** anim fps: n=%d, time=%d, speed=%ufps\n", anim_frames, (int) ticks, fps);
+    // set owner for body
+    _c((mPanelPiece*)body)->setOwner((mPanelPiece*)body, (mWidget*)self);
+
+    return;
 }
 
-void anim_fps_test_start (int new_status)
+/* paint the disjoint rects the pieces invalidated one by one, instead of
+ * the bounding rect MiniGUI hands us. */
+static void s_paintDamageRects(mContainerCtrl *self, mPanelPiece *body, HDC hdc)
 {
-    if (1 == new_status) {
-        printf ("**** anim test start ...\n");
+    RECT rects[PANEL_MAX_DAMAGE_RECTS];
+    PCLIPRGN rgn;
+    int i, n;
+
+    /* whatever the paint dc clips to beyond our rects was invalidated by
+     * someone else (expose, InvalidateRect from the app), paint it too */
+    rgn = CreateClipRgn();
+    if (rgn) {
+        GetClipRegion(hdc, rgn);
+        for (i = 0; i < body->nr_damage_rects; ++i)
+            SubtractClipRect(rgn, &body->damageRects[i]);
+        if (!IsEmptyClipRgn(rgn))
+            PanelPiece_addDamageRect(body, &rgn->rcBound);
+        DestroyClipRgn(rgn);
     }
     else {
-        printf ("**** anim test end.\n");
+        PanelPiece_addDamageRect(body, &body->invalidRect);
     }
-        
-    if (anim_fps_test_status == 1) { /* print result of previous test */
-        int ticks = times (NULL) - anim_start_time;
-        anim_fps_test_tellspeed (ticks);
+
+    /* pieces may invalidate again while painting, keep that for the next round */
+    n = body->nr_damage_rects;
+    memcpy(rects, body->damageRects, n * sizeof(RECT));
+    body->nr_damage_rects = 0;
+
+    for (i = 0; i < n; ++i) {
+        body->invalidRect = rects[i];
+        SelectClipRect(hdc, &rects[i]);
+        PAINTTRACE_PAINT(body, hdc, (mObject*)self, (DWORD)NULL);
     }
+}
 
-    /* set status */
-    anim_fps_test_status = new_status;
+/* area the paint of body is going to cover */
+static unsigned int s_damagedPixels(mPanelPiece *body)
+{
+    unsigned int pixels = 0;
+    RECT rc;
+    int i;
 
-    anim_frames = 0;
-    anim_start_time = times (NULL);
+    if (body->nr_damage_rects > 0) {
+        for (i = 0; i < body->nr_damage_rects; ++i)
+            pixels += RECTW(body->damageRects[i]) * RECTH(body->damageRects[i]);
+        return pixels;
+    }
+
+    _c(body)->getRect(body, &rc);
+    if (RECTW(body->invalidRect) && RECTH(body->invalidRect))
+        IntersectRect(&rc, &rc, &body->invalidRect);
+    return RECTW(rc) * RECTH(rc);
 }
-#endif
 
 static void mContainerCtrl_onPaint(mContainerCtrl *self, HDC hdc, const PCLIPRGN pclip) {
-    if (self->body) {
-        _c((mHotPiece*)(self->body))->paint(
-                (mHotPiece*)self->body, hdc, (mObject*)self, (DWORD)NULL);
-
-#ifdef ENABLE_ANIM_FPS_TEST
+    double start = FrameStats_now();
 
-        if (anim_fps_test_status == 1) { /* running */
+    /* this paint serves whatever was scheduled */
+    if (self->paintScheduled) {
+        KillTimer(self->hwnd, (LINT)self);
+        self->paintScheduled = FALSE;
+    }
+    self->lastPaintTime = s_now();
+    self->deferredPaints = 0;
 
-            /* printf ("+++++++++ %d\n", random ()); */
+    if (self->body) {
+        mPanelPiece *body = (mPanelPiece*)self->body;
+        unsigned int pixels = g_frameStatsEnabled ? s_damagedPixels(body) : 0;
 
-            if ( (times (NULL) - anim_start_time) >= ANIM_TICKS_MAX ) { /* end test */
-                printf ("**** anim test timeout.\n");
-                anim_fps_test_start (0);
-            }
-            else {
-                ++ anim_frames;
-            }
+        if (body->nr_damage_rects > 0) {
+            s_paintDamageRects(self, body, hdc);
         }
-#endif
+        else {
+            PAINTTRACE_PAINT(body, hdc, (mObject*)self, (DWORD)NULL);
+        }
+        /* the damage is consumed, paint outside MSG_PAINT covers everything */
+        memset(&body->invalidRect, 0, sizeof(RECT));
+        LayerCache_trim();
+
+        FrameStats_endFrame(start, pixels);
     }
 }
 
@@ -126,27 +273,28 @@ static BOOL mContainerCtrl_onEraseBkgnd(mContainerCtrl *self, HDC hdc, const REC
 }
 */
 
-#ifdef DEBUG
 static LRESULT mContainerCtrl_wndProc(mWidget* self,  UINT message, WPARAM wParam, LPARAM lParam)
 {
     if (message == MSG_PAINT) {
         mPanelPiece* topPanel = (mPanelPiece*)self->body;
         if ( NULL != topPanel) {
+            /* hand the damage to the top panel, it is lost after BeginPaint */
             RECT* invalidRect = &topPanel->invalidRect;
             GetUpdateRect(self->hwnd, invalidRect);
-            _MG_PRINTF ("piece is %p, invalidRect is (%d,%d,%d,%d).\n", topPanel, invalidRect->left, 
+            _DBG_PRINTF ("piece is %p, invalidRect is (%d,%d,%d,%d).\n", topPanel, invalidRect->left, 
                     invalidRect->top, invalidRect->right, invalidRect->bottom);
         }
     }
 
     return Class(mWidget).wndProc((mWidget*)self, message, wParam, lParam);
 }
-#endif
 
 BEGIN_CMPT_CLASS(mContainerCtrl, mWidget)
+    CLASS_METHOD_MAP(mContainerCtrl, construct)
+    CLASS_METHOD_MAP(mContainerCtrl, destroy)
+    CLASS_METHOD_MAP(mContainerCtrl, setProperty)
+    CLASS_METHOD_MAP(mContainerCtrl, getProperty)
     CLASS_METHOD_MAP(mContainerCtrl, setBody)
-#ifdef DEBUG
     CLASS_METHOD_MAP(mContainerCtrl, wndProc)
-#endif
     CLASS_METHOD_MAP(mContainerCtrl, onPaint)
 END_CMPT_CLASS
@@ -0,0 +1,154 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+BOOL g_frameStatsEnabled = FALSE;
+
+static const unsigned int s_bucketLimits[FRAMESTATS_NR_BUCKETS] = {
+    1, 2, 4, 8, 12, 16, 20, 33, 50, 100, 200, (unsigned int)-1
+};
+
+static FRAME_STATS s_stats = { .budget_ms = FRAMESTATS_DEFAULT_BUDGET };
+static double s_firstFrame;
+static double s_lastFrame;
+static int s_nr_clocks;
+
+double FrameStats_now(void)
+{
+    struct timespec ts;
+
+    if (!g_frameStatsEnabled)
+        return 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void FrameStats_endFrame(double start, unsigned int pixels)
+{
+    double now, ms;
+    int i;
+
+    /* turned on in the middle of the frame */
+    if (start == 0 || !g_frameStatsEnabled)
+        return;
+
+    now = FrameStats_now();
+    ms = now - start;
+
+    for (i = 0; i < FRAMESTATS_NR_BUCKETS - 1; ++i) {
+        if (ms < s_bucketLimits[i])
+            break;
+    }
+    s_stats.histogram[i]++;
+
+    if (s_stats.nr_frames++ == 0)
+        s_firstFrame = start;
+    s_lastFrame = now;
+
+    s_stats.total_ms += ms;
+    if (ms > s_stats.max_ms)
+        s_stats.max_ms = ms;
+    if (ms > s_stats.budget_ms)
+        s_stats.over_budget++;
+    s_stats.pixels += pixels;
+    s_stats.last_pixels = pixels;
+}
+
+void FrameStats_endComposite(double start)
+{
+    if (start == 0 || !g_frameStatsEnabled)
+        return;
+    s_stats.composite_ms += FrameStats_now() - start;
+}
+
+void FrameStats_clockStarted(void)
+{
+    s_nr_clocks++;
+}
+
+void FrameStats_clockStopped(void)
+{
+    s_nr_clocks--;
+}
+
+void ncs4TouchEnableFrameStats(BOOL enable)
+{
+    g_frameStatsEnabled = enable;
+}
+
+BOOL ncs4TouchFrameStatsEnabled(void)
+{
+    return g_frameStatsEnabled;
+}
+
+void ncs4TouchSetFrameBudget(unsigned int budget)
+{
+    s_stats.budget_ms = budget;
+}
+
+BOOL ncs4TouchGetFrameStats(FRAME_STATS* stats)
+{
+    *stats = s_stats;
+    memcpy(stats->bucket_limits, s_bucketLimits, sizeof(s_bucketLimits));
+
+    /* what is not spent blitting is spent painting */
+    stats->paint_ms = stats->total_ms - stats->composite_ms;
+    if (stats->paint_ms < 0)
+        stats->paint_ms = 0;
+    stats->elapsed_ms = stats->nr_frames ? s_lastFrame - s_firstFrame : 0;
+    stats->nr_clocks = s_nr_clocks;
+    stats->nr_animations = PieceAnim_getTrackCount();
+
+    return g_frameStatsEnabled;
+}
+
+void ncs4TouchResetFrameStats(void)
+{
+    unsigned int budget = s_stats.budget_ms;
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.budget_ms = budget;
+}
@@ -30,6 +30,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <minigui/common.h>
 #include <minigui/minigui.h>
@@ -65,6 +66,8 @@ static void init_mgncs4touch_pieces_classes(void)
 
 BOOL ncs4TouchInitialize(void)
 {
+    const char *env;
+
     if (!ncsTouchInitRenderers()) {
         LOGE("mGNCS4Touch: Init renderer error.\n");
         return FALSE;
@@ -76,6 +79,11 @@ BOOL ncs4TouchInitialize(void)
 
     init_mgncs4touch_pieces_classes();
 
+    if ((env = getenv("NCS4TOUCH_FRAMESTATS")) && atoi(env) != 0)
+        ncs4TouchEnableFrameStats(TRUE);
+    if ((env = getenv("NCS4TOUCH_PAINTTRACE")) && *env)
+        PaintTrace_start(0);
+
     MGNCS_REGISTER_COMPONENT(mAnimation);
     MGNCS_REGISTER_COMPONENT_EX(mSwitchButton, WS_NONE, WS_EX_NONE, IDC_ARROW, NCS_BGC_3DBODY);
     MGNCS_REGISTER_COMPONENT_EX(mNewTrackBar, WS_NONE, WS_EX_NONE, IDC_ARROW, NCS_BGC_3DBODY);
@@ -93,6 +101,8 @@ BOOL ncs4TouchInitialize(void)
     MGNCS_INIT_CLASS(mItemIterator);
     MGNCS_INIT_CLASS(mListItemManager);
     MGNCS_INIT_CLASS(mListItemIterator);
+    MGNCS_INIT_CLASS(mArrayItemManager);
+    MGNCS_INIT_CLASS(mArrayItemIterator);
     MGNCS_INIT_CLASS(mRotateSwitchPiece);
     MGNCS_INIT_CLASS(mPanelPiece);
     MGNCS_INIT_CLASS(mItemPiece);
@@ -130,6 +140,14 @@ BOOL ncs4TouchInitialize(void)
 
 void ncs4TouchUninitialize(void)
 {
+    const char *env;
+
+    if ((env = getenv("NCS4TOUCH_PAINTTRACE")) && *env) {
+        PaintTrace_stop();
+        if (!PaintTrace_dump(env))
+            LOGE("mGNCS4Touch: can not write the paint trace to %s.\n", env);
+    }
+
     MGNCS_UNREG_COMPONENT(mAnimation);
     MGNCS_UNREG_COMPONENT(mSwitchButton);
     MGNCS_UNREG_COMPONENT(mNewTrackBar);
@@ -0,0 +1,349 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+/* most recently composited first */
+static list_t s_layers = { &s_layers, &s_layers };
+static size_t s_budget = LAYERCACHE_DEFAULT_BUDGET;
+static size_t s_bytes;
+static unsigned int s_nr_layers;
+static unsigned int s_hits;
+static unsigned int s_misses;
+static unsigned int s_repaints;
+static unsigned int s_evictions;
+
+static void s_dropLevels(mPieceItem* item)
+{
+    int i;
+
+    for (i = 0; i < LAYERCACHE_MAX_LEVEL; i++) {
+        HDC dc = item->cacheLevels[i];
+        size_t bytes;
+
+        if (dc == HDC_INVALID)
+            continue;
+        bytes = (size_t)(GetGDCapability(dc, GDCAP_MAXX) + 1)
+            * (GetGDCapability(dc, GDCAP_MAXY) + 1)
+            * GetGDCapability(dc, GDCAP_BPP);
+        DeleteMemDC(dc);
+        item->cacheLevels[i] = HDC_INVALID;
+        item->cacheBytes -= bytes;
+        s_bytes -= bytes;
+    }
+}
+
+static void s_dropLayer(mPieceItem* item)
+{
+    s_dropLevels(item);
+    list_del(&item->cacheList);
+    DeleteMemDC(item->cacheDC);
+    item->cacheDC = HDC_INVALID;
+    s_bytes -= item->cacheBytes;
+    s_nr_layers--;
+    item->cacheBytes = 0;
+}
+
+/* evict the coldest layers */
+static void s_shrink(size_t budget)
+{
+    while (s_bytes > budget && s_layers.prev != &s_layers) {
+        mPieceItem* item = list_entry(s_layers.prev, mPieceItem, cacheList);
+
+        s_dropLayer(item);
+        s_evictions++;
+    }
+}
+
+static HDC s_createLayer(HDC ref_dc, int w, int h)
+{
+    HDC dc;
+
+    /* layers keep the alpha channel of the piece, so they can be blended
+     * over whatever is under them */
+    if (GetGDCapability(ref_dc, GDCAP_AMASK) == 0) {
+        dc = CreateMemDC(w, h, 32, MEMDC_FLAG_HWSURFACE,
+                0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+    }
+    else {
+        dc = CreateCompatibleDCEx(ref_dc, w, h);
+    }
+    if (dc != HDC_INVALID)
+        SetMemDCAlpha(dc, MEMDC_FLAG_SRCPIXELALPHA, 0);
+    return dc;
+}
+
+HDC LayerCache_acquire(mPieceItem* item, HDC ref_dc, int w, int h)
+{
+    if (w <= 0 || h <= 0)
+        return HDC_INVALID;
+
+    if (item->cacheDC != HDC_INVALID) {
+        if (GetGDCapability(item->cacheDC, GDCAP_MAXX) + 1 == (Uint32)w
+                && GetGDCapability(item->cacheDC, GDCAP_MAXY) + 1 == (Uint32)h) {
+            list_del(&item->cacheList);
+            list_add(&item->cacheList, &s_layers);
+            s_hits++;
+            /* blitting from the layer blends, whoever used it last */
+            SetMemDCAlpha(item->cacheDC, MEMDC_FLAG_SRCPIXELALPHA, 0);
+            return item->cacheDC;
+        }
+        /* the piece was resized */
+        s_dropLayer(item);
+    }
+
+    item->cacheDC = s_createLayer(ref_dc, w, h);
+    if (item->cacheDC == HDC_INVALID)
+        return HDC_INVALID;
+
+    item->cacheBytes = (size_t)w * h * GetGDCapability(item->cacheDC, GDCAP_BPP);
+    list_add(&item->cacheList, &s_layers);
+    s_bytes += item->cacheBytes;
+    s_nr_layers++;
+    s_misses++;
+    SetRect(&item->cacheDirtyRect, 0, 0, w, h);
+
+    return item->cacheDC;
+}
+
+void LayerCache_release(mPieceItem* item)
+{
+    if (item->cacheDC != HDC_INVALID)
+        s_dropLayer(item);
+    SetRectEmpty(&item->cacheDirtyRect);
+}
+
+void LayerCache_markDirty(mPieceItem* item, const RECT* rc)
+{
+    RECT dirty;
+
+    if (item->cacheDC == HDC_INVALID)
+        return;
+
+    if (rc == NULL) {
+        SetRect(&dirty, 0, 0,
+                GetGDCapability(item->cacheDC, GDCAP_MAXX) + 1,
+                GetGDCapability(item->cacheDC, GDCAP_MAXY) + 1);
+        rc = &dirty;
+    }
+
+    if (IsRectEmpty(&item->cacheDirtyRect))
+        item->cacheDirtyRect = *rc;
+    else
+        GetBoundRect(&item->cacheDirtyRect, &item->cacheDirtyRect, rc);
+}
+
+BOOL LayerCache_takeDirtyRect(mPieceItem* item, RECT* rc)
+{
+    if (item->cacheDC == HDC_INVALID || IsRectEmpty(&item->cacheDirtyRect))
+        return FALSE;
+
+    *rc = item->cacheDirtyRect;
+    SetRectEmpty(&item->cacheDirtyRect);
+    /* the levels are derived from the old content */
+    s_dropLevels(item);
+    s_repaints++;
+    return TRUE;
+}
+
+/* average of four pixels weighted by their alpha, so transparent pixels
+ * do not darken the opaque ones next to them; the result stays straight
+ * (not premultiplied) alpha like the layer it comes from */
+static Uint32 s_averagePixels(const Uint32* p, int ashift)
+{
+    Uint32 sum[4] = {0, 0, 0, 0};
+    Uint32 asum = 0, out = 0;
+    int i, c;
+
+    for (i = 0; i < 4; i++) {
+        Uint32 a = (p[i] >> ashift) & 0xFF;
+
+        asum += a;
+        for (c = 0; c < 4; c++)
+            sum[c] += ((p[i] >> (c * 8)) & 0xFF) * a;
+    }
+    if (asum == 0)
+        return 0;
+
+    for (c = 0; c < 4; c++) {
+        Uint32 v = (c * 8 == ashift) ? (asum + 2) / 4 : (sum[c] + asum / 2) / asum;
+        out |= v << (c * 8);
+    }
+    return out;
+}
+
+/* 2x2 box filter of a 32 bit dc into one of half its size, weighted by
+ * alpha when the dc has an alpha channel */
+static BOOL s_downsample(HDC src, HDC dst)
+{
+    int sw, sh, spitch, dw, dh, dpitch, x, y;
+    int ashift = -1;
+    Uint32 amask = GetGDCapability(src, GDCAP_AMASK);
+    Uint8 *sbits, *dbits;
+    RECT rc;
+
+    if (amask == 0xFF000000 || amask == 0x00FF0000
+            || amask == 0x0000FF00 || amask == 0x000000FF) {
+        for (ashift = 0; !(amask & (1u << ashift)); ashift += 8)
+            ;
+    }
+
+    SetRect(&rc, 0, 0, GetGDCapability(src, GDCAP_MAXX) + 1,
+            GetGDCapability(src, GDCAP_MAXY) + 1);
+    sbits = LockDC(src, &rc, &sw, &sh, &spitch);
+    if (sbits == NULL)
+        return FALSE;
+    SetRect(&rc, 0, 0, GetGDCapability(dst, GDCAP_MAXX) + 1,
+            GetGDCapability(dst, GDCAP_MAXY) + 1);
+    dbits = LockDC(dst, &rc, &dw, &dh, &dpitch);
+    if (dbits == NULL) {
+        UnlockDC(src);
+        return FALSE;
+    }
+
+    for (y = 0; y < dh; y++) {
+        const Uint32 *row0 = (const Uint32*)(sbits + (2 * y) * spitch);
+        const Uint32 *row1 = (const Uint32*)(sbits
+                + (2 * y + 1 < sh ? 2 * y + 1 : sh - 1) * spitch);
+        Uint32 *out = (Uint32*)(dbits + y * dpitch);
+
+        for (x = 0; x < dw; x++) {
+            int x0 = 2 * x;
+            int x1 = (x0 + 1 < sw) ? x0 + 1 : sw - 1;
+            Uint32 p0 = row0[x0], p1 = row0[x1], p2 = row1[x0], p3 = row1[x1];
+
+            if (ashift >= 0) {
+                Uint32 p[4];
+
+                p[0] = p0; p[1] = p1; p[2] = p2; p[3] = p3;
+                out[x] = s_averagePixels(p, ashift);
+            }
+            else {
+                /* two channels per word, each sum fits in its 16 bits */
+                Uint32 lo = (p0 & 0x00FF00FF) + (p1 & 0x00FF00FF)
+                    + (p2 & 0x00FF00FF) + (p3 & 0x00FF00FF) + 0x00020002;
+                Uint32 hi = ((p0 >> 8) & 0x00FF00FF) + ((p1 >> 8) & 0x00FF00FF)
+                    + ((p2 >> 8) & 0x00FF00FF) + ((p3 >> 8) & 0x00FF00FF) + 0x00020002;
+
+                out[x] = ((lo >> 2) & 0x00FF00FF) | (((hi >> 2) & 0x00FF00FF) << 8);
+            }
+        }
+    }
+
+    UnlockDC(dst);
+    UnlockDC(src);
+    return TRUE;
+}
+
+HDC LayerCache_getLevel(mPieceItem* item, int level)
+{
+    HDC prev = item->cacheDC;
+    int i;
+
+    if (prev == HDC_INVALID || GetGDCapability(prev, GDCAP_BPP) != 4)
+        return prev;
+
+    if (level > LAYERCACHE_MAX_LEVEL)
+        level = LAYERCACHE_MAX_LEVEL;
+
+    for (i = 0; i < level; i++) {
+        HDC dc = item->cacheLevels[i];
+
+        if (dc == HDC_INVALID) {
+            int w = (GetGDCapability(prev, GDCAP_MAXX) + 1) / 2;
+            int h = (GetGDCapability(prev, GDCAP_MAXY) + 1) / 2;
+            size_t bytes;
+
+            if (w <= 0 || h <= 0)
+                break;
+            dc = CreateCompatibleDCEx(prev, w, h);
+            if (dc == HDC_INVALID)
+                break;
+            if (!s_downsample(prev, dc)) {
+                DeleteMemDC(dc);
+                break;
+            }
+            SetMemDCAlpha(dc, MEMDC_FLAG_SRCPIXELALPHA, 0);
+
+            bytes = (size_t)w * h * GetGDCapability(dc, GDCAP_BPP);
+            item->cacheLevels[i] = dc;
+            item->cacheBytes += bytes;
+            s_bytes += bytes;
+        }
+        prev = dc;
+    }
+    return prev;
+}
+
+void LayerCache_setBudget(size_t budget)
+{
+    s_budget = budget;
+    s_shrink(s_budget);
+}
+
+void LayerCache_trim(void)
+{
+    s_shrink(s_budget);
+}
+
+size_t LayerCache_getBudget(void)
+{
+    return s_budget;
+}
+
+void LayerCache_getStats(LAYERCACHE_STATS* stats)
+{
+    stats->hits = s_hits;
+    stats->misses = s_misses;
+    stats->repaints = s_repaints;
+    stats->evictions = s_evictions;
+    stats->nr_layers = s_nr_layers;
+    stats->bytes = s_bytes;
+    stats->budget = s_budget;
+}
+
+void LayerCache_resetStats(void)
+{
+    s_hits = s_misses = s_repaints = s_evictions = 0;
+}
+
@@ -49,6 +49,12 @@ static void mLayoutManager_reLayout(mLayoutManager *self, mItemIterator* iter, i
     return;
 }
 
+static void mLayoutManager_invalidate(mLayoutManager *self, int index)
+{
+    return;
+}
+
 BEGIN_MINI_CLASS(mLayoutManager, mObject)
     CLASS_METHOD_MAP(mLayoutManager, reLayout)
+    CLASS_METHOD_MAP(mLayoutManager, invalidate)
 END_MINI_CLASS
@@ -44,38 +44,146 @@
 
 #include "mgncs4touch.h"
 
-static void mLineVBox_reLayout(mLineVBox *self, mItemIterator* iter, int w, int h)
+#define MIN_ROWS 16
+
+static void mLineVBox_construct(mLineVBox *self, DWORD add_data)
+{
+    Class(mLayoutManager).construct((mLayoutManager*)self, add_data);
+    self->gap = 0;
+    self->heights = NULL;
+    self->offsets = NULL;
+    self->widths = NULL;
+    self->nr_rows = 0;
+    self->max_rows = 0;
+    self->dirtyFrom = 0;
+}
+
+static void mLineVBox_destroy(mLineVBox *self)
+{
+    free(self->heights);
+    free(self->offsets);
+    free(self->widths);
+    Class(mLayoutManager).destroy((mLayoutManager*)self);
+}
+
+static BOOL s_reserve(mLineVBox *self, int nr)
+{
+    int max;
+    int *heights, *offsets, *widths;
+
+    if (nr < self->max_rows)
+        return TRUE;
+
+    max = self->max_rows ? self->max_rows * 2 : MIN_ROWS;
+    while (max <= nr)
+        max *= 2;
+
+    heights = (int*)realloc(self->heights, max * sizeof(int));
+    if (heights)
+        self->heights = heights;
+    widths = (int*)realloc(self->widths, max * sizeof(int));
+    if (widths)
+        self->widths = widths;
+    /* one more for the end of the last row */
+    offsets = (int*)realloc(self->offsets, (max + 1) * sizeof(int));
+    if (offsets)
+        self->offsets = offsets;
+    if (!heights || !widths || !offsets)
+        return FALSE;
+
+    self->max_rows = max;
+    return TRUE;
+}
+
+/* lays the rows from dirtyFrom on out and refreshes the cache */
+static void s_update(mLineVBox *self, mItemIterator* iter)
 {
     RECT rc;
-    int y = 0;
     mPieceItem* item = NULL;
+    mItemIterator* rewind = NULL;
+    int i = 0, start = self->dirtyFrom;
+    int y;
+
+    if (start > self->nr_rows)
+        start = self->nr_rows;
+
+    if (start > 0)
+        rewind = _c(iter)->duplicate(iter);
+    while (i < start && (item = _c(iter)->next(iter)))
+        i++;
+    if (i < start) {
+        /* rows went away without invalidate, any of them could have been
+         * above start, so lay out from the top */
+        if (NULL == rewind) {
+            self->nr_rows = 0;
+            self->dirtyFrom = 0;
+            return;
+        }
+        iter = rewind;
+        i = start = 0;
+    }
+
+    y = start > 0 ? self->offsets[start] : 0;
     while((item = _c(iter)->next(iter))) {
         mHotPiece* piece = _c(item)->getPiece(item);
         _c(item)->setY(item, y);
         _c(piece)->getRect(piece, &rc);
+        if (s_reserve(self, i)) {
+            self->heights[i] = RECTH(rc);
+            self->widths[i] = RECTW(rc);
+            self->offsets[i] = y;
+        }
         y += (RECTH(rc) + self->gap);
+        i++;
     }
+    if (rewind)
+        DELETE(rewind);
+
+    if (self->max_rows < i) {
+        /* out of memory, do a full pass next time */
+        self->nr_rows = 0;
+        self->dirtyFrom = 0;
+        return;
+    }
+    if (self->offsets)
+        self->offsets[i] = y;
+    self->nr_rows = i;
+    self->dirtyFrom = i;
+}
 
+static void mLineVBox_reLayout(mLineVBox *self, mItemIterator* iter, int w, int h)
+{
+    s_update(self, iter);
     return;
 }
 
+static void mLineVBox_invalidate(mLineVBox *self, int index)
+{
+    if (index < 0)
+        index = 0;
+    if (index < self->dirtyFrom)
+        self->dirtyFrom = index;
+}
+
 static void mLineVBox_setGap(mLineVBox *self, int gap)
 {
-    self->gap = gap;
+    if (self->gap != gap) {
+        self->gap = gap;
+        self->dirtyFrom = 0;
+    }
 }
 
 static void mLineVBox_getLayoutRect(mLineVBox *self, mItemIterator* iter, RECT* rect)
 {
-    RECT rc;
+    int i;
     int h = 0;
     int w = 0;
-    mPieceItem* item = NULL;
-    while((item = _c(iter)->next(iter))) {
-        mHotPiece* piece = _c(item)->getPiece(item);
-        _c(piece)->getRect(piece, &rc);
-        h += RECTH(rc);
-        if (RECTW(rc) > w) {
-            w = RECTW(rc);
+
+    s_update(self, iter);
+    for (i = 0; i < self->nr_rows; i++) {
+        h += self->heights[i];
+        if (self->widths[i] > w) {
+            w = self->widths[i];
         }
     }
     rect->top = rect->left = 0;
@@ -84,8 +192,46 @@ static void mLineVBox_getLayoutRect(mLineVBox *self, mItemIterator* iter, RECT*
     return;
 }
 
+/* the row covering y, a gap belongs to the row above it, -1 if none */
+static int mLineVBox_indexAtY(mLineVBox *self, int y)
+{
+    int low = 0, high = self->nr_rows - 1;
+
+    if (self->nr_rows == 0 || y < 0 || y >= self->offsets[self->nr_rows])
+        return -1;
+
+    /* the last row starting at or above y */
+    while (low < high) {
+        int mid = (low + high + 1) >> 1;
+        if (self->offsets[mid] <= y)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
+
+/* y of the row, yOfIndex(getRowCount()) is the end of the last row's gap */
+static int mLineVBox_yOfIndex(mLineVBox *self, int index)
+{
+    if (index < 0 || index > self->nr_rows)
+        return -1;
+    return self->nr_rows ? self->offsets[index] : 0;
+}
+
+static int mLineVBox_getRowCount(mLineVBox *self)
+{
+    return self->nr_rows;
+}
+
 BEGIN_MINI_CLASS(mLineVBox, mLayoutManager)
+    CLASS_METHOD_MAP(mLineVBox, construct)
+    CLASS_METHOD_MAP(mLineVBox, destroy)
     CLASS_METHOD_MAP(mLineVBox, reLayout)
+    CLASS_METHOD_MAP(mLineVBox, invalidate)
     CLASS_METHOD_MAP(mLineVBox, setGap)
     CLASS_METHOD_MAP(mLineVBox, getLayoutRect)
+    CLASS_METHOD_MAP(mLineVBox, indexAtY)
+    CLASS_METHOD_MAP(mLineVBox, yOfIndex)
+    CLASS_METHOD_MAP(mLineVBox, getRowCount)
 END_MINI_CLASS
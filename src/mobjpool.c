@@ -0,0 +1,243 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+/* slabs are aligned on their size, the slab of an object is found by
+ * masking its address */
+#define SLAB_SIZE           4096
+#define SIZE_CLASS_SHIFT    4
+#define NR_SIZE_CLASSES     (OBJPOOL_MAX_SIZE >> SIZE_CLASS_SHIFT)
+
+typedef struct _slab {
+    struct _slab *prev;     /* in the partial list of its class */
+    struct _slab *next;
+    void *free;             /* free objects, linked through their first word */
+    int nr_used;
+    int size_class;
+    char *page;
+} slab_t;
+
+typedef struct _size_class {
+    slab_t *partial;        /* slabs with free objects */
+    int nr_empty;
+} size_class_t;
+
+static size_class_t s_classes[NR_SIZE_CLASSES];
+static PTR_MAP *s_slabs;    /* page -> slab_t */
+static OBJPOOL_STATS s_stats;
+
+static inline int s_sizeClass(size_t size)
+{
+    return (int)((size + (1 << SIZE_CLASS_SHIFT) - 1) >> SIZE_CLASS_SHIFT) - 1;
+}
+
+static inline size_t s_objSize(int size_class)
+{
+    return (size_t)(size_class + 1) << SIZE_CLASS_SHIFT;
+}
+
+static void s_unlinkSlab(size_class_t *sc, slab_t *slab)
+{
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        sc->partial = slab->next;
+    if (slab->next)
+        slab->next->prev = slab->prev;
+    slab->prev = slab->next = NULL;
+}
+
+static void s_linkSlab(size_class_t *sc, slab_t *slab)
+{
+    slab->prev = NULL;
+    slab->next = sc->partial;
+    if (sc->partial)
+        sc->partial->prev = slab;
+    sc->partial = slab;
+}
+
+static slab_t *s_createSlab(int size_class)
+{
+    size_t obj_size = s_objSize(size_class);
+    slab_t *slab;
+    void *page;
+    char *obj;
+    size_t i;
+
+    if (s_slabs == NULL && (s_slabs = PtrMap_create()) == NULL)
+        return NULL;
+
+    if (posix_memalign(&page, SLAB_SIZE, SLAB_SIZE) != 0)
+        return NULL;
+    slab = (slab_t*)calloc(1, sizeof(slab_t));
+    if (slab == NULL || !PtrMap_put(s_slabs, page, slab)) {
+        free(slab);
+        free(page);
+        return NULL;
+    }
+
+    slab->page = (char*)page;
+    slab->size_class = size_class;
+    /* lowest addresses first out */
+    for (i = SLAB_SIZE / obj_size; i > 0; i--) {
+        obj = slab->page + (i - 1) * obj_size;
+        *(void**)obj = slab->free;
+        slab->free = obj;
+    }
+
+    s_stats.nr_slabs++;
+    s_stats.bytes += SLAB_SIZE;
+    return slab;
+}
+
+static void s_destroySlab(slab_t *slab)
+{
+    PtrMap_remove(s_slabs, slab->page);
+    free(slab->page);
+    free(slab);
+
+    s_stats.nr_slabs--;
+    s_stats.bytes -= SLAB_SIZE;
+}
+
+void* ObjPool_alloc(size_t size)
+{
+    size_class_t *sc;
+    slab_t *slab;
+    void *obj;
+    int size_class;
+
+    if (size == 0 || size > OBJPOOL_MAX_SIZE)
+        return calloc(1, size);
+
+    size_class = s_sizeClass(size);
+    sc = &s_classes[size_class];
+    slab = sc->partial;
+    if (slab == NULL) {
+        if ((slab = s_createSlab(size_class)) == NULL)
+            return calloc(1, size);
+        s_linkSlab(sc, slab);
+        sc->nr_empty++;
+    }
+
+    if (slab->nr_used++ == 0)
+        sc->nr_empty--;
+    obj = slab->free;
+    slab->free = *(void**)obj;
+    if (slab->free == NULL)
+        s_unlinkSlab(sc, slab);
+
+    if (++s_stats.live > s_stats.peak)
+        s_stats.peak = s_stats.live;
+    s_stats.allocs++;
+
+    memset(obj, 0, s_objSize(size_class));
+    return obj;
+}
+
+void ObjPool_free(void* ptr)
+{
+    size_class_t *sc;
+    slab_t *slab = NULL;
+
+    if (ptr == NULL)
+        return;
+
+    if (s_slabs)
+        slab = (slab_t*)PtrMap_get(s_slabs,
+                (void*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_SIZE - 1)));
+    if (slab == NULL) {
+        /* from calloc(), too big or created by NEW() */
+        free(ptr);
+        return;
+    }
+
+    sc = &s_classes[slab->size_class];
+    if (slab->free == NULL)
+        s_linkSlab(sc, slab);
+    *(void**)ptr = slab->free;
+    slab->free = ptr;
+    s_stats.live--;
+
+    if (--slab->nr_used == 0) {
+        if (sc->nr_empty > 0) {
+            s_unlinkSlab(sc, slab);
+            s_destroySlab(slab);
+        }
+        else {
+            sc->nr_empty++;
+        }
+    }
+}
+
+mObject* ObjPool_newObject(mObjectClass* _class)
+{
+    mObject *obj;
+
+    if (_class == NULL)
+        return NULL;
+
+    obj = (mObject*)ObjPool_alloc(_class->objSize);
+    if (obj == NULL)
+        return NULL;
+
+    obj->_class = _class;
+    _class->construct(obj, 0);
+    return obj;
+}
+
+void ObjPool_deleteObject(mObject* obj)
+{
+    if (obj == NULL)
+        return;
+
+    _c(obj)->destroy(obj);
+    ObjPool_free(obj);
+}
+
+void ObjPool_getStats(OBJPOOL_STATS* stats)
+{
+    if (stats)
+        *stats = s_stats;
+}
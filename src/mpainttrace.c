@@ -0,0 +1,155 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+#ifdef __GNUC__
+#define RING_CLAIM(p)   __sync_fetch_and_add((p), 1)
+#else
+#define RING_CLAIM(p)   ((*(p))++)
+#endif
+
+typedef struct _trace_event {
+    const char *name;
+    const void *piece;
+    double ts;              /* us */
+    double dur;             /* us */
+} trace_event_t;
+
+BOOL g_paintTraceOn = FALSE;
+
+static trace_event_t *s_ring;
+static unsigned int s_mask;
+static volatile unsigned int s_head;    /* events recorded so far */
+
+static double s_usecs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+BOOL PaintTrace_start(int nr_events)
+{
+    unsigned int size = 1;
+
+    if (nr_events <= 0)
+        nr_events = PAINTTRACE_DEFAULT_EVENTS;
+    while (size < (unsigned int)nr_events)
+        size <<= 1;
+
+    g_paintTraceOn = FALSE;
+    if (s_ring == NULL || s_mask + 1 != size) {
+        free(s_ring);
+        s_ring = (trace_event_t*)malloc(size * sizeof(trace_event_t));
+        if (s_ring == NULL) {
+            s_mask = 0;
+            return FALSE;
+        }
+        s_mask = size - 1;
+    }
+
+    s_head = 0;
+    g_paintTraceOn = TRUE;
+    return TRUE;
+}
+
+void PaintTrace_stop(void)
+{
+    g_paintTraceOn = FALSE;
+}
+
+void PaintTrace_clear(void)
+{
+    s_head = 0;
+}
+
+void PaintTrace_paint(mHotPiece* piece, HDC hdc, mObject* owner, DWORD add_data)
+{
+    double start = s_usecs();
+    trace_event_t *ev;
+
+    _c(piece)->paint(piece, hdc, owner, add_data);
+
+    /* stopped while painting */
+    if (!g_paintTraceOn)
+        return;
+
+    ev = &s_ring[RING_CLAIM(&s_head) & s_mask];
+    ev->name = _c(piece)->typeName;
+    ev->piece = piece;
+    ev->ts = start;
+    ev->dur = s_usecs() - start;
+}
+
+BOOL PaintTrace_dump(const char* path)
+{
+    unsigned int head = s_head;
+    unsigned int first, i;
+    FILE *fp;
+
+    if (s_ring == NULL)
+        return FALSE;
+
+    fp = fopen(path, "w");
+    if (fp == NULL)
+        return FALSE;
+
+    /* the oldest events were overwritten once the ring wrapped */
+    first = head > s_mask + 1 ? head - (s_mask + 1) : 0;
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for (i = first; i != head; ++i) {
+        const trace_event_t *ev = &s_ring[i & s_mask];
+        fprintf(fp, "{\"name\":\"%s\",\"cat\":\"paint\",\"ph\":\"X\","
+                "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"piece\":\"%p\"}}%s\n",
+                ev->name ? ev->name : "?", ev->ts, ev->dur, ev->piece,
+                i + 1 != head ? "," : "");
+    }
+    fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,423 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+/* the mGEff animation of a track carries its index and a generation, so
+ * that it no longer touches the slot once the track is gone */
+#define TRACK_INDEX_BITS    16
+#define MAX_TRACKS          (1 << TRACK_INDEX_BITS)
+#define TRACK_ID(i)         ((intptr_t)(((unsigned)s_tracks.gen[i] << TRACK_INDEX_BITS) | (i)))
+#define TRACK_INDEX(id)     ((int)((id) & (MAX_TRACKS - 1)))
+#define TRACK_GEN(id)       ((unsigned short)((uintptr_t)(id) >> TRACK_INDEX_BITS))
+
+/* panels invalidated with one bound each per flush, more go one by one */
+#define MAX_DAMAGED_PANELS  8
+
+/* rotation is in [0, 180) */
+#define MAX_ANGLE           180.0
+
+/* one entry per track in each array, a free one has no item */
+static struct {
+    int nr;
+    int max;
+    int nr_live;
+    int nr_dirty;
+    mPieceItem **item;
+    mPanelPiece **panel;
+    unsigned short *gen;
+    unsigned char *prop;
+    unsigned char *dirty;
+    float *from;        /* two values per track */
+    float *to;
+    float *progress;    /* eased, from the mGEff animation */
+} s_tracks;
+
+typedef struct _panel_damage {
+    mPanelPiece *panel;
+    RECT rc;
+} panel_damage_t;
+
+#define GROW_ARRAY(array, n) \
+    do { \
+        void *p = realloc(s_tracks.array, (n) * sizeof(*s_tracks.array)); \
+        if (!p) return FALSE; \
+        s_tracks.array = p; \
+    } while (0)
+
+static BOOL s_grow(void)
+{
+    int max = s_tracks.max ? s_tracks.max * 2 : 16;
+
+    if (max > MAX_TRACKS)
+        max = MAX_TRACKS;
+    if (max == s_tracks.max)
+        return FALSE;
+
+    GROW_ARRAY(item, max);
+    GROW_ARRAY(panel, max);
+    GROW_ARRAY(gen, max);
+    GROW_ARRAY(prop, max);
+    GROW_ARRAY(dirty, max);
+    GROW_ARRAY(from, max * 2);
+    GROW_ARRAY(to, max * 2);
+    GROW_ARRAY(progress, max);
+
+    memset(s_tracks.gen + s_tracks.max, 0,
+            (max - s_tracks.max) * sizeof(*s_tracks.gen));
+    s_tracks.max = max;
+    return TRUE;
+}
+
+static void s_freeTrack(int i)
+{
+    if (s_tracks.dirty[i]) {
+        s_tracks.dirty[i] = 0;
+        s_tracks.nr_dirty--;
+    }
+    s_tracks.item[i] = NULL;
+    s_tracks.gen[i]++;
+    s_tracks.nr_live--;
+
+    while (s_tracks.nr > 0 && s_tracks.item[s_tracks.nr - 1] == NULL)
+        s_tracks.nr--;
+}
+
+/* the track already animating prop of item, or a free one */
+static int s_getTrack(mPieceItem *item, int prop)
+{
+    int i, free_slot = -1;
+
+    for (i = 0; i < s_tracks.nr; i++) {
+        if (s_tracks.item[i] == item && s_tracks.prop[i] == prop) {
+            s_freeTrack(i);
+            return i;
+        }
+        if (s_tracks.item[i] == NULL && free_slot < 0)
+            free_slot = i;
+    }
+
+    if (free_slot >= 0)
+        return free_slot;
+    if (s_tracks.nr == s_tracks.max && !s_grow())
+        return -1;
+    return s_tracks.nr;
+}
+
+static BOOL s_isLive(intptr_t id)
+{
+    int i = TRACK_INDEX(id);
+
+    return i < s_tracks.nr && s_tracks.item[i]
+        && s_tracks.gen[i] == TRACK_GEN(id);
+}
+
+static void s_onProgress(MGEFF_ANIMATION handle, void *target, intptr_t id, void *value)
+{
+    mPanelPiece *top;
+    int i = TRACK_INDEX(id);
+
+    if (!s_isLive(id))
+        return;
+
+    s_tracks.progress[i] = *(float*)value;
+    if (!s_tracks.dirty[i]) {
+        s_tracks.dirty[i] = 1;
+        s_tracks.nr_dirty++;
+    }
+
+    top = PanelPiece_getTopPanel((mHotPiece*)s_tracks.panel[i]);
+    if (top == NULL) {
+        /* not on screen, nothing would flush it */
+        PieceAnim_flush();
+    }
+    else if (top->update_anim == NULL) {
+        PanelPiece_runFrameClock((mHotPiece*)top, 0);
+    }
+}
+
+static void s_onFinished(MGEFF_ANIMATION handle)
+{
+    intptr_t id = (intptr_t)mGEffAnimationGetContext(handle);
+
+    if (!s_isLive(id))
+        return;
+
+    /* the last value lands before anybody else hears about the end */
+    if (s_tracks.dirty[TRACK_INDEX(id)])
+        PieceAnim_flush();
+    s_freeTrack(TRACK_INDEX(id));
+}
+
+MGEFF_ANIMATION PieceAnim_create(mHotPiece* panel, mPieceItem* item,
+        int prop, const float from[2], const float to[2],
+        int duration, enum EffMotionType curve)
+{
+    MGEFF_ANIMATION anim;
+    float start = 0.0, end = 1.0;
+    int i;
+
+    assert(panel && item);
+
+    i = s_getTrack(item, prop);
+    if (i < 0)
+        return NULL;
+
+    s_tracks.item[i] = item;
+    s_tracks.panel[i] = (mPanelPiece*)panel;
+    s_tracks.prop[i] = (unsigned char)prop;
+    s_tracks.dirty[i] = 0;
+    s_tracks.from[i * 2] = from[0];
+    s_tracks.from[i * 2 + 1] = from[1];
+    s_tracks.to[i * 2] = to[0];
+    s_tracks.to[i * 2 + 1] = to[1];
+    s_tracks.progress[i] = 0.0;
+    s_tracks.nr_live++;
+    if (i == s_tracks.nr)
+        s_tracks.nr++;
+
+    anim = mGEffAnimationCreate(item, s_onProgress, TRACK_ID(i), MGEFF_FLOAT);
+    if (anim == NULL) {
+        s_freeTrack(i);
+        return NULL;
+    }
+
+    mGEffAnimationSetStartValue(anim, &start);
+    mGEffAnimationSetEndValue(anim, &end);
+    mGEffAnimationSetDuration(anim, duration);
+    mGEffAnimationSetCurve(anim, curve);
+    mGEffAnimationSetContext(anim, (void*)TRACK_ID(i));
+    mGEffAnimationSetFinishedCb(anim, s_onFinished);
+    return anim;
+}
+
+/* what item paints may cover, in the coordinates of its panel */
+static void s_getDamageRect(mPieceItem *item, RECT *prc)
+{
+    if (_c(item->piece)->getRect(item->piece, prc) < 0) {
+        SetRectEmpty(prc);
+        return;
+    }
+
+    if (item->wscalefactor > 1) {
+        int offset = (RECTWP(prc) * item->wscalefactor - RECTWP(prc)) / 2;
+        prc->left -= offset;
+        prc->right += offset;
+    }
+    if (item->hscalefactor > 1) {
+        int offset = (RECTHP(prc) * item->hscalefactor - RECTHP(prc)) / 2;
+        prc->top -= offset;
+        prc->bottom += offset;
+    }
+
+    OffsetRect(prc, item->x, item->y);
+}
+
+static void s_unionRect(RECT *dst, const RECT *src)
+{
+    RECT bound;
+
+    if (IsRectEmpty(src))
+        return;
+    if (IsRectEmpty(dst)) {
+        *dst = *src;
+        return;
+    }
+    GetBoundRect(&bound, dst, src);
+    *dst = bound;
+}
+
+static int s_round(float v)
+{
+    return v < 0 ? (int)(v - 0.5) : (int)(v + 0.5);
+}
+
+/* what s_applyTrack did with the value of a track */
+enum {
+    TRACK_UNCHANGED,
+    TRACK_WRITTEN,      /* into the item, the flush invalidates it */
+    TRACK_DELEGATED,    /* to the setter a subclass of the panel overrides */
+};
+
+/* write the value of track i */
+static int s_applyTrack(int i)
+{
+    mPieceItem *item = s_tracks.item[i];
+    mPanelPiece *panel = s_tracks.panel[i];
+    float p = s_tracks.progress[i];
+    float v0 = s_tracks.from[i * 2] + (s_tracks.to[i * 2] - s_tracks.from[i * 2]) * p;
+    float v1 = s_tracks.from[i * 2 + 1] + (s_tracks.to[i * 2 + 1] - s_tracks.from[i * 2 + 1]) * p;
+
+    switch (s_tracks.prop[i]) {
+        case PIECEANIM_MOVE:
+            {
+                int x = s_round(v0), y = s_round(v1);
+                RECT old_rc, new_rc;
+
+                if (x == item->x && y == item->y)
+                    return TRACK_UNCHANGED;
+                if (_c(panel)->movePiece != Class(mPanelPiece).movePiece) {
+                    _c(panel)->movePiece(panel, item->piece, x, y);
+                    return TRACK_DELEGATED;
+                }
+
+                if (SpatialIndex_isValid(panel->spatialIndex)) {
+                    _c(item->piece)->getRect(item->piece, &old_rc);
+                    new_rc = old_rc;
+                    OffsetRect(&old_rc, item->x, item->y);
+                    OffsetRect(&new_rc, x, y);
+                    SpatialIndex_move(panel->spatialIndex, item, &old_rc, &new_rc);
+                }
+                item->x = x;
+                item->y = y;
+            }
+            break;
+
+        case PIECEANIM_SCALE:
+            if (v0 < 0.0) v0 = 0.0;
+            if (v1 < 0.0) v1 = 0.0;
+            if (v0 == item->wscalefactor && v1 == item->hscalefactor)
+                return TRACK_UNCHANGED;
+            if (_c(panel)->scalePiece != Class(mPanelPiece).scalePiece) {
+                _c(panel)->scalePiece(panel, item->piece, v0, v1);
+                return TRACK_DELEGATED;
+            }
+
+            item->wscalefactor = v0;
+            item->hscalefactor = v1;
+            /* back to its size, the layer kept for scaling is not needed */
+            if (v0 == 1.0 && v1 == 1.0 && !item->isEnableCache)
+                LayerCache_release(item);
+            break;
+
+        case PIECEANIM_ROTATE:
+            if (v0 >= MAX_ANGLE)
+                v0 = 0.0;
+            if (v0 == item->normalVector.angle)
+                return TRACK_UNCHANGED;
+            if (_c(panel)->rotatePiece != Class(mPanelPiece).rotatePiece) {
+                _c(panel)->rotatePiece(panel, item->piece, v0, item->normalVector.x,
+                        item->normalVector.y, item->normalVector.z);
+                return TRACK_DELEGATED;
+            }
+            item->normalVector.angle = v0;
+            break;
+
+        case PIECEANIM_ALPHA:
+            if (s_round(v0) == item->alpha)
+                return TRACK_UNCHANGED;
+            if (_c(panel)->setPieceAlpha != Class(mPanelPiece).setPieceAlpha) {
+                _c(panel)->setPieceAlpha(panel, item->piece, s_round(v0));
+                return TRACK_DELEGATED;
+            }
+            item->alpha = s_round(v0);
+            break;
+
+        default:
+            assert(0);
+            return TRACK_UNCHANGED;
+    }
+    return TRACK_WRITTEN;
+}
+
+void PieceAnim_flush(void)
+{
+    panel_damage_t damage[MAX_DAMAGED_PANELS];
+    int nr_damage = 0;
+    int i, j;
+
+    if (s_tracks.nr_dirty == 0)
+        return;
+
+    for (i = 0; i < s_tracks.nr && s_tracks.nr_dirty > 0; i++) {
+        mPanelPiece *panel;
+        RECT rc, new_rc;
+
+        if (!s_tracks.dirty[i])
+            continue;
+        s_tracks.dirty[i] = 0;
+        s_tracks.nr_dirty--;
+
+        /* an overriding setter invalidates on its own, and may flush the
+         * other tracks itself before its value lands */
+        s_getDamageRect(s_tracks.item[i], &rc);
+        if (s_applyTrack(i) != TRACK_WRITTEN)
+            continue;
+        s_getDamageRect(s_tracks.item[i], &new_rc);
+        s_unionRect(&rc, &new_rc);
+        if (IsRectEmpty(&rc))
+            continue;
+
+        panel = s_tracks.panel[i];
+        for (j = 0; j < nr_damage && damage[j].panel != panel; j++);
+        if (j < nr_damage) {
+            s_unionRect(&damage[j].rc, &rc);
+        }
+        else if (nr_damage < MAX_DAMAGED_PANELS) {
+            damage[nr_damage].panel = panel;
+            damage[nr_damage].rc = rc;
+            nr_damage++;
+        }
+        else {
+            PanelPiece_invalidatePiece((mHotPiece*)panel, &rc);
+        }
+    }
+
+    for (j = 0; j < nr_damage; j++)
+        PanelPiece_invalidatePiece((mHotPiece*)damage[j].panel, &damage[j].rc);
+}
+
+void PieceAnim_dropItem(mPieceItem* item)
+{
+    int i;
+
+    for (i = s_tracks.nr - 1; i >= 0; i--) {
+        if (s_tracks.item[i] == item)
+            s_freeTrack(i);
+    }
+}
+
+int PieceAnim_getTrackCount(void)
+{
+    return s_tracks.nr_live;
+}
@@ -57,14 +57,17 @@ static void mPieceItem_construct(mPieceItem *self, DWORD add_data)
 
     self->isEnableCache = FALSE;
     self->cacheDC = HDC_INVALID;
+    self->cacheBytes = 0;
+    SetRectEmpty(&self->cacheDirtyRect);
+    self->cacheLevels[0] = self->cacheLevels[1] = HDC_INVALID;
+    SetRectEmpty(&self->visibleRect);
+    self->index = -1;
 }
 
 static void mPieceItem_destroy(mPieceItem *self)
 {
-    if (self->cacheDC != HDC_INVALID) {
-        DeleteMemDC(self->cacheDC);
-        self->cacheDC = HDC_INVALID;
-    }
+    LayerCache_release(self);
+    PieceAnim_dropItem(self);
 
     Class(mObject).destroy((mObject*)self);
 }
@@ -0,0 +1,199 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+#define PTRMAP_MIN_CAPACITY     8
+
+typedef struct _ptrmap_slot {
+    const void* key;
+    void* value;
+} ptrmap_slot_t;
+
+struct _PTR_MAP {
+    ptrmap_slot_t* slots;
+    int capacity;       /* power of 2 */
+    int count;
+};
+
+static inline unsigned int s_hash(const void* key, int capacity)
+{
+    /* objects are at least 8 bytes aligned, drop the always zero bits */
+    unsigned long v = (unsigned long)key >> 3;
+    return (unsigned int)(v * 2654435761u) & (capacity - 1);
+}
+
+static BOOL s_resize(PTR_MAP* map, int capacity)
+{
+    ptrmap_slot_t* old = map->slots;
+    int old_capacity = map->capacity;
+    int i;
+
+    map->slots = (ptrmap_slot_t*)calloc(capacity, sizeof(ptrmap_slot_t));
+    if (map->slots == NULL) {
+        map->slots = old;
+        return FALSE;
+    }
+    map->capacity = capacity;
+
+    for (i = 0; i < old_capacity; ++i) {
+        if (old[i].key) {
+            unsigned int pos = s_hash(old[i].key, capacity);
+            while (map->slots[pos].key)
+                pos = (pos + 1) & (capacity - 1);
+            map->slots[pos] = old[i];
+        }
+    }
+    free(old);
+    return TRUE;
+}
+
+static int s_find(PTR_MAP* map, const void* key)
+{
+    unsigned int pos;
+
+    if (map->count == 0)
+        return -1;
+
+    pos = s_hash(key, map->capacity);
+    while (map->slots[pos].key) {
+        if (map->slots[pos].key == key)
+            return pos;
+        pos = (pos + 1) & (map->capacity - 1);
+    }
+    return -1;
+}
+
+PTR_MAP* PtrMap_create(void)
+{
+    return (PTR_MAP*)calloc(1, sizeof(PTR_MAP));
+}
+
+void PtrMap_destroy(PTR_MAP* map)
+{
+    if (map) {
+        free(map->slots);
+        free(map);
+    }
+}
+
+void* PtrMap_get(PTR_MAP* map, const void* key)
+{
+    int pos;
+
+    if (map == NULL || (pos = s_find(map, key)) < 0)
+        return NULL;
+    return map->slots[pos].value;
+}
+
+BOOL PtrMap_put(PTR_MAP* map, const void* key, void* value)
+{
+    unsigned int pos;
+
+    assert(key && value);
+
+    if (map == NULL)
+        return FALSE;
+
+    /* keep the load factor under 3/4 */
+    if ((map->count + 1) * 4 > map->capacity * 3) {
+        if (!s_resize(map, map->capacity ? map->capacity * 2 : PTRMAP_MIN_CAPACITY))
+            return FALSE;
+    }
+
+    pos = s_hash(key, map->capacity);
+    while (map->slots[pos].key) {
+        if (map->slots[pos].key == key) {
+            map->slots[pos].value = value;
+            return TRUE;
+        }
+        pos = (pos + 1) & (map->capacity - 1);
+    }
+    map->slots[pos].key = key;
+    map->slots[pos].value = value;
+    map->count++;
+    return TRUE;
+}
+
+void PtrMap_remove(PTR_MAP* map, const void* key)
+{
+    int hole, pos;
+
+    if (map == NULL || (hole = s_find(map, key)) < 0)
+        return;
+
+    /* backward shift the following cluster, so no tombstones are needed */
+    pos = hole;
+    for (;;) {
+        unsigned int home;
+
+        pos = (pos + 1) & (map->capacity - 1);
+        if (map->slots[pos].key == NULL)
+            break;
+
+        home = s_hash(map->slots[pos].key, map->capacity);
+        /* move it if its home is not in the (hole, pos] range */
+        if ((pos > hole && (home <= (unsigned int)hole || home > (unsigned int)pos))
+                || (pos < hole && (home <= (unsigned int)hole && home > (unsigned int)pos))) {
+            map->slots[hole] = map->slots[pos];
+            hole = pos;
+        }
+    }
+    map->slots[hole].key = NULL;
+    map->slots[hole].value = NULL;
+    map->count--;
+}
+
+void PtrMap_clear(PTR_MAP* map)
+{
+    if (map && map->count) {
+        memset(map->slots, 0, map->capacity * sizeof(ptrmap_slot_t));
+        map->count = 0;
+    }
+}
+
+int PtrMap_count(PTR_MAP* map)
+{
+    return map ? map->count : 0;
+}
+
@@ -0,0 +1,272 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+typedef struct _index_entry {
+    void *data;
+    int order;
+} index_entry_t;
+
+typedef struct _index_cell {
+    index_entry_t *entries;    /* sorted by order, topmost last */
+    int count;
+    int capacity;
+} index_cell_t;
+
+struct _SPATIAL_INDEX {
+    int cell_size;
+    int w;
+    int h;
+    int cols;
+    int rows;
+    index_cell_t *cells;
+    BOOL valid;
+};
+
+/* cells covered by rc, FALSE if it is outside of the index */
+static BOOL s_cellRange(SPATIAL_INDEX* index, const RECT *rc,
+        int *c0, int *r0, int *c1, int *r1)
+{
+    if (index->cells == NULL || IsRectEmpty(rc)
+            || rc->right <= 0 || rc->bottom <= 0
+            || rc->left >= index->w || rc->top >= index->h)
+        return FALSE;
+
+    *c0 = rc->left > 0 ? rc->left / index->cell_size : 0;
+    *r0 = rc->top > 0 ? rc->top / index->cell_size : 0;
+    *c1 = (MIN(rc->right, index->w) - 1) / index->cell_size;
+    *r1 = (MIN(rc->bottom, index->h) - 1) / index->cell_size;
+    return TRUE;
+}
+
+static BOOL s_cellInsert(index_cell_t *cell, void *data, int order)
+{
+    int i;
+
+    if (cell->count == cell->capacity) {
+        int capacity = cell->capacity ? cell->capacity * 2 : 4;
+        index_entry_t *entries = (index_entry_t*)realloc(cell->entries,
+                capacity * sizeof(index_entry_t));
+        if (entries == NULL)
+            return FALSE;
+        cell->entries = entries;
+        cell->capacity = capacity;
+    }
+
+    /* entries mostly come in z-order, search the slot from the top */
+    for (i = cell->count; i > 0 && cell->entries[i - 1].order > order; --i)
+        ;
+    memmove(&cell->entries[i + 1], &cell->entries[i],
+            (cell->count - i) * sizeof(index_entry_t));
+    cell->entries[i].data = data;
+    cell->entries[i].order = order;
+    cell->count++;
+    return TRUE;
+}
+
+/* return the order of the removed entry, -1 if not found */
+static int s_cellRemove(index_cell_t *cell, void *data)
+{
+    int i, order;
+
+    for (i = 0; i < cell->count; ++i) {
+        if (cell->entries[i].data == data) {
+            order = cell->entries[i].order;
+            cell->count--;
+            memmove(&cell->entries[i], &cell->entries[i + 1],
+                    (cell->count - i) * sizeof(index_entry_t));
+            return order;
+        }
+    }
+    return -1;
+}
+
+static void s_freeCells(SPATIAL_INDEX* index)
+{
+    int i;
+
+    if (index->cells) {
+        for (i = 0; i < index->cols * index->rows; ++i)
+            free(index->cells[i].entries);
+        free(index->cells);
+        index->cells = NULL;
+    }
+    index->cols = index->rows = 0;
+}
+
+SPATIAL_INDEX* SpatialIndex_create(int cell_size)
+{
+    SPATIAL_INDEX* index = (SPATIAL_INDEX*)calloc(1, sizeof(SPATIAL_INDEX));
+
+    if (index) {
+        index->cell_size = cell_size > 0 ? cell_size : SPATIALINDEX_DEFAULT_CELL;
+        index->valid = FALSE;
+    }
+    return index;
+}
+
+void SpatialIndex_destroy(SPATIAL_INDEX* index)
+{
+    if (index) {
+        s_freeCells(index);
+        free(index);
+    }
+}
+
+void SpatialIndex_reset(SPATIAL_INDEX* index, int w, int h)
+{
+    int cols, rows, i;
+
+    w = MAX(w, 1);
+    h = MAX(h, 1);
+    cols = (w + index->cell_size - 1) / index->cell_size;
+    rows = (h + index->cell_size - 1) / index->cell_size;
+
+    if (index->cells && cols == index->cols && rows == index->rows) {
+        /* keep the entry arrays, they are likely to be refilled alike */
+        for (i = 0; i < cols * rows; ++i)
+            index->cells[i].count = 0;
+    }
+    else {
+        s_freeCells(index);
+        index->cells = (index_cell_t*)calloc(cols * rows, sizeof(index_cell_t));
+        if (index->cells) {
+            index->cols = cols;
+            index->rows = rows;
+        }
+    }
+
+    index->w = w;
+    index->h = h;
+    index->valid = (index->cells != NULL);
+}
+
+void SpatialIndex_invalidate(SPATIAL_INDEX* index)
+{
+    if (index)
+        index->valid = FALSE;
+}
+
+BOOL SpatialIndex_isValid(SPATIAL_INDEX* index)
+{
+    return index && index->valid;
+}
+
+BOOL SpatialIndex_insert(SPATIAL_INDEX* index, void *data, int order, const RECT *rc)
+{
+    int c0, r0, c1, r1, c, r;
+
+    if (!s_cellRange(index, rc, &c0, &r0, &c1, &r1))
+        return TRUE;
+
+    for (r = r0; r <= r1; ++r) {
+        for (c = c0; c <= c1; ++c) {
+            if (!s_cellInsert(&index->cells[r * index->cols + c], data, order)) {
+                index->valid = FALSE;
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+void SpatialIndex_remove(SPATIAL_INDEX* index, void *data, const RECT *rc)
+{
+    int c0, r0, c1, r1, c, r;
+
+    if (!s_cellRange(index, rc, &c0, &r0, &c1, &r1))
+        return;
+
+    for (r = r0; r <= r1; ++r) {
+        for (c = c0; c <= c1; ++c) {
+            s_cellRemove(&index->cells[r * index->cols + c], data);
+        }
+    }
+}
+
+BOOL SpatialIndex_move(SPATIAL_INDEX* index, void *data,
+        const RECT *old_rc, const RECT *new_rc)
+{
+    int c0, r0, c1, r1, c, r;
+    int order = -1;
+
+    if (!index->valid)
+        return FALSE;
+
+    if (s_cellRange(index, old_rc, &c0, &r0, &c1, &r1)) {
+        for (r = r0; r <= r1; ++r) {
+            for (c = c0; c <= c1; ++c) {
+                int found = s_cellRemove(&index->cells[r * index->cols + c], data);
+                if (found >= 0)
+                    order = found;
+            }
+        }
+    }
+
+    if (order < 0) {
+        /* it was outside of the index, its z-order is unknown */
+        index->valid = FALSE;
+        return FALSE;
+    }
+    return SpatialIndex_insert(index, data, order, new_rc);
+}
+
+void* SpatialIndex_query(SPATIAL_INDEX* index, int x, int y,
+        SPATIALINDEX_HIT_CB hit, void *ctx)
+{
+    index_cell_t *cell;
+    int i;
+
+    if (!index->valid || index->cells == NULL
+            || x < 0 || y < 0 || x >= index->w || y >= index->h)
+        return NULL;
+
+    cell = &index->cells[(y / index->cell_size) * index->cols + x / index->cell_size];
+    for (i = cell->count - 1; i >= 0; --i) {
+        if (hit(cell->entries[i].data, x, y, ctx))
+            return cell->entries[i].data;
+    }
+    return NULL;
+}
+
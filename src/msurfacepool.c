@@ -0,0 +1,288 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+typedef struct _surface_entry {
+    list_t list;
+    HDC dc;
+    int w;
+    int h;
+    Uint32 format;
+    size_t bytes;
+} surface_entry_t;
+
+struct _SURFACE_POOL {
+    list_t idle;    /* most recently released first */
+    list_t spare;   /* unused entries, so put() does not allocate */
+    size_t budget;
+    size_t idle_bytes;
+    unsigned int nr_idle;
+    unsigned int nr_busy;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+};
+
+/* depth plus the red/alpha channel positions is enough to tell the
+ * formats we create apart (RGB565, RGB888, ARGB8888, ABGR8888) */
+#define MAKE_FORMAT(depth, rmask, amask) \
+    (((Uint32)(depth) << 24) ^ ((Uint32)(rmask) >> 8) ^ (Uint32)(amask))
+
+#define ARGB_RMASK  0x00FF0000
+#define ARGB_GMASK  0x0000FF00
+#define ARGB_BMASK  0x000000FF
+#define ARGB_AMASK  0xFF000000
+
+static Uint32 s_getFormat(HDC hdc)
+{
+    return MAKE_FORMAT(GetGDCapability(hdc, GDCAP_DEPTH),
+            GetGDCapability(hdc, GDCAP_RMASK),
+            GetGDCapability(hdc, GDCAP_AMASK));
+}
+
+static HDC s_createSurface(HDC ref_dc, int w, int h)
+{
+    if (ref_dc == HDC_INVALID) {
+        return CreateMemDC(w, h, 32, MEMDC_FLAG_HWSURFACE,
+                ARGB_RMASK, ARGB_GMASK, ARGB_BMASK, ARGB_AMASK);
+    }
+    return CreateCompatibleDCEx(ref_dc, w, h);
+}
+
+static void s_evictTail(SURFACE_POOL* pool)
+{
+    surface_entry_t* entry = list_entry(pool->idle.prev, surface_entry_t, list);
+
+    list_del(&entry->list);
+    DeleteMemDC(entry->dc);
+    pool->idle_bytes -= entry->bytes;
+    pool->nr_idle--;
+    pool->evictions++;
+
+    entry->dc = HDC_INVALID;
+    list_add(&entry->list, &pool->spare);
+}
+
+static void s_shrink(SURFACE_POOL* pool, size_t budget)
+{
+    while (pool->idle_bytes > budget && !list_empty(&pool->idle)) {
+        s_evictTail(pool);
+    }
+}
+
+SURFACE_POOL* SurfacePool_create(size_t budget)
+{
+    SURFACE_POOL* pool = (SURFACE_POOL*)calloc(1, sizeof(SURFACE_POOL));
+
+    if (pool) {
+        INIT_LIST_HEAD(&pool->idle);
+        INIT_LIST_HEAD(&pool->spare);
+        pool->budget = budget;
+    }
+    return pool;
+}
+
+void SurfacePool_destroy(SURFACE_POOL* pool)
+{
+    list_t *i, *n;
+
+    if (pool == NULL)
+        return;
+
+    if (pool->nr_busy > 0) {
+        _ERR_PRINTF("mGNCS4Touch>SurfacePool: %u surfaces are not released\n",
+                pool->nr_busy);
+    }
+
+    SurfacePool_clear(pool);
+    list_for_each_safe(i, n, &pool->spare) {
+        list_del(i);
+        free(list_entry(i, surface_entry_t, list));
+    }
+    free(pool);
+}
+
+/* ref_dc is HDC_INVALID for an ARGB surface */
+static HDC s_get(SURFACE_POOL* pool, HDC ref_dc, Uint32 format, int w, int h)
+{
+    list_t* i;
+    HDC dc;
+
+    if (w <= 0 || h <= 0)
+        return HDC_INVALID;
+
+    if (pool == NULL)
+        return s_createSurface(ref_dc, w, h);
+
+    list_for_each(i, &pool->idle) {
+        surface_entry_t* entry = list_entry(i, surface_entry_t, list);
+        if (entry->w == w && entry->h == h && entry->format == format) {
+            dc = entry->dc;
+            list_del(&entry->list);
+            pool->idle_bytes -= entry->bytes;
+            pool->nr_idle--;
+
+            entry->dc = HDC_INVALID;
+            list_add(&entry->list, &pool->spare);
+
+            pool->nr_busy++;
+            pool->hits++;
+            return dc;
+        }
+    }
+
+    dc = s_createSurface(ref_dc, w, h);
+    if (dc != HDC_INVALID) {
+        pool->nr_busy++;
+        pool->misses++;
+    }
+    return dc;
+}
+
+HDC SurfacePool_get(SURFACE_POOL* pool, HDC ref_dc, int w, int h)
+{
+    return s_get(pool, ref_dc, s_getFormat(ref_dc), w, h);
+}
+
+HDC SurfacePool_getARGB(SURFACE_POOL* pool, int w, int h)
+{
+    return s_get(pool, HDC_INVALID,
+            MAKE_FORMAT(32, ARGB_RMASK, ARGB_AMASK), w, h);
+}
+
+void SurfacePool_put(SURFACE_POOL* pool, HDC memdc)
+{
+    surface_entry_t* entry;
+    int w, h;
+    size_t bytes;
+
+    if (memdc == HDC_INVALID)
+        return;
+
+    if (pool == NULL) {
+        DeleteMemDC(memdc);
+        return;
+    }
+
+    assert(pool->nr_busy > 0);
+    pool->nr_busy--;
+
+    w = GetGDCapability(memdc, GDCAP_MAXX) + 1;
+    h = GetGDCapability(memdc, GDCAP_MAXY) + 1;
+    bytes = (size_t)w * h * GetGDCapability(memdc, GDCAP_BPP);
+
+    if (bytes > pool->budget) {
+        DeleteMemDC(memdc);
+        pool->evictions++;
+        return;
+    }
+
+    if (list_empty(&pool->spare)) {
+        entry = (surface_entry_t*)calloc(1, sizeof(surface_entry_t));
+        if (entry == NULL) {
+            DeleteMemDC(memdc);
+            return;
+        }
+    }
+    else {
+        entry = list_entry(pool->spare.next, surface_entry_t, list);
+        list_del(&entry->list);
+    }
+
+    /* forget the state left by the last user, surfaces with an alpha
+     * channel are created blending per pixel */
+    SelectClipRect(memdc, NULL);
+    if (GetGDCapability(memdc, GDCAP_AMASK))
+        SetMemDCAlpha(memdc, MEMDC_FLAG_SRCPIXELALPHA, 0);
+    else
+        SetMemDCAlpha(memdc, 0, 0);
+
+    entry->dc = memdc;
+    entry->w = w;
+    entry->h = h;
+    entry->format = s_getFormat(memdc);
+    entry->bytes = bytes;
+
+    s_shrink(pool, pool->budget - bytes);
+
+    list_add(&entry->list, &pool->idle);
+    pool->idle_bytes += bytes;
+    pool->nr_idle++;
+}
+
+void SurfacePool_setBudget(SURFACE_POOL* pool, size_t budget)
+{
+    if (pool) {
+        pool->budget = budget;
+        s_shrink(pool, budget);
+    }
+}
+
+void SurfacePool_clear(SURFACE_POOL* pool)
+{
+    if (pool) {
+        s_shrink(pool, 0);
+    }
+}
+
+void SurfacePool_getStats(SURFACE_POOL* pool, SURFACEPOOL_STATS* stats)
+{
+    memset(stats, 0, sizeof(SURFACEPOOL_STATS));
+    if (pool) {
+        stats->hits = pool->hits;
+        stats->misses = pool->misses;
+        stats->evictions = pool->evictions;
+        stats->nr_idle = pool->nr_idle;
+        stats->nr_busy = pool->nr_busy;
+        stats->idle_bytes = pool->idle_bytes;
+        stats->budget = pool->budget;
+    }
+}
+
+void SurfacePool_resetStats(SURFACE_POOL* pool)
+{
+    if (pool) {
+        pool->hits = pool->misses = pool->evictions = 0;
+    }
+}
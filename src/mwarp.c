@@ -0,0 +1,332 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+#include <minigui/fixedmath.h>
+
+#include <mgncs/mgncs.h>
+#include <mgeff/mgeff.h>
+
+#include "mgncs4touch.h"
+
+/* one destination line of the warp: a row for WARP_AXIS_X, a column for
+ * WARP_AXIS_Y; all values 16.16 */
+typedef struct _warp_line {
+    Sint32 u;       /* source coordinate along the flip */
+    Sint32 start;   /* destination range across the line */
+    Sint32 end;
+    Sint32 step;    /* source pixels across per destination pixel */
+    Sint32 v;       /* running source coordinate across, WARP_AXIS_Y only */
+    int first;      /* destination pixels across covered by the line */
+    int last;
+} warp_line_t;
+
+/* internal mode bit next to the WARP_FLAG_* ones */
+#define WARP_BLEND  0x8000
+
+/* grown on demand, painting only happens in the GUI thread */
+static warp_line_t *s_lines;
+static int s_nr_lines;
+
+/* first pixel whose center is at or after the 16.16 position */
+#define PIXEL_AT(pos)   ((int)(((pos) - 0x8000 + 0xFFFF) >> 16))
+
+static BOOL s_reserveLines(int n)
+{
+    if (n > s_nr_lines) {
+        warp_line_t *lines = (warp_line_t*)realloc(s_lines, n * sizeof(warp_line_t));
+        if (lines == NULL)
+            return FALSE;
+        s_lines = lines;
+        s_nr_lines = n;
+    }
+    return TRUE;
+}
+
+/*
+ * Project a card n pixels long along the flip and m across it, seen from
+ * 3 * n away, and fill s_lines[from, to) with the destination lines it
+ * covers. Like the old scene based code, the edge coming closer keeps its
+ * size and everything else shrinks with the perspective.
+ */
+static BOOL s_setupLines(int n, int m, float angle, int *from, int *to)
+{
+    Sint32 a, c, s, half, z, d0, d1, dmin, r0, r1, x0, x1, len;
+    int d = 3 * n;
+    int i;
+
+    /* fold to -90~90 degrees, the back of the card shows the front again;
+     * fixed point angles have 256 for a full turn */
+    if (angle < 90)
+        a = ftofix(-angle * 64 / 90);
+    else
+        a = ftofix((180 - angle) * 64 / 90);
+    c = fixcos(a);
+    s = fixsin(a);
+
+    half = n << 15;
+    /* depth of the edge at 0, the one at n is at -z */
+    z = (Sint32)(((Sint64)half * s) >> 16);
+    d0 = (d << 16) + z;
+    d1 = (d << 16) - z;
+    dmin = MIN(d0, d1);
+    r0 = (Sint32)(((Sint64)dmin << 16) / d0);
+    r1 = (Sint32)(((Sint64)dmin << 16) / d1);
+
+    x0 = half - (Sint32)(((((Sint64)half * c) >> 16) * r0) >> 16);
+    x1 = half + (Sint32)(((((Sint64)half * c) >> 16) * r1) >> 16);
+    len = x1 - x0;
+    /* seen from the edge */
+    if (len < 0x10000)
+        return FALSE;
+
+    *from = MAX(PIXEL_AT(x0), 0);
+    *to = MIN(PIXEL_AT(x1), n);
+    if (*from >= *to || !s_reserveLines(n))
+        return FALSE;
+
+    for (i = *from; i < *to; i++) {
+        warp_line_t *line = s_lines + i;
+        /* position in the quad, the relative size and, perspective
+         * correct, the position on the card */
+        Sint32 f = (Sint32)((((Sint64)(i << 16) + 0x8000 - x0) << 16) / len);
+        Sint32 r = r0 + (Sint32)(((Sint64)f * (r1 - r0)) >> 16);
+        Sint32 t = (Sint32)(((Sint64)f * r1) / r);
+        Sint32 span = m * r;
+
+        line->u = MIN(MAX(t * n, 0), (n << 16) - 1);
+        line->start = (m << 15) - span / 2;
+        line->end = line->start + span;
+        line->step = (Sint32)(((Sint64)1 << 32) / r);
+        line->first = MAX(PIXEL_AT(line->start), 0);
+        line->last = MIN(PIXEL_AT(line->end), m);
+    }
+    return TRUE;
+}
+
+/* source coordinate of the center of destination pixel p across line */
+static inline Sint32 s_across(const warp_line_t *line, int p)
+{
+    return (Sint32)(((Sint64)((p << 16) + 0x8000 - line->start) * line->step) >> 16);
+}
+
+/* per 8 bit channel (a * (256 - w) + b * w) / 256, two channels at a
+ * time; w is 0 to 256 */
+static inline Uint32 s_lerp(Uint32 a, Uint32 b, Uint32 w)
+{
+    Uint32 rb = ((a & 0x00FF00FF) * (256 - w) + (b & 0x00FF00FF) * w) >> 8;
+    Uint32 ag = ((a >> 8) & 0x00FF00FF) * (256 - w) + ((b >> 8) & 0x00FF00FF) * w;
+
+    return (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+}
+
+typedef struct _warp_surface {
+    Uint8 *bits;
+    int w;
+    int h;
+    int pitch;
+} warp_surface_t;
+
+/* sample the 32 bit source at the 16.16 pixel center (x, y) */
+static inline Uint32 s_sample32(const warp_surface_t *src, Sint32 x, Sint32 y, BOOL bilinear)
+{
+    const Uint32 *row0, *row1;
+    int x0, x1, y0, y1;
+    Uint32 fx, fy;
+
+    if (!bilinear) {
+        y0 = MIN(y >> 16, src->h - 1);
+        x0 = MIN(x >> 16, src->w - 1);
+        return ((const Uint32*)(src->bits + y0 * src->pitch))[x0];
+    }
+
+    /* the four pixels around the sample point */
+    x -= 0x8000;
+    y -= 0x8000;
+    x0 = MIN(MAX(x >> 16, 0), src->w - 1);
+    y0 = MIN(MAX(y >> 16, 0), src->h - 1);
+    x1 = MIN(x0 + 1, src->w - 1);
+    y1 = MIN(y0 + 1, src->h - 1);
+    fx = x < 0 ? 0 : (x >> 8) & 0xFF;
+    fy = y < 0 ? 0 : (y >> 8) & 0xFF;
+
+    row0 = (const Uint32*)(src->bits + y0 * src->pitch);
+    row1 = (const Uint32*)(src->bits + y1 * src->pitch);
+    return s_lerp(s_lerp(row0[x0], row0[x1], fx),
+            s_lerp(row1[x0], row1[x1], fx), fy);
+}
+
+/* source over destination, straight alpha in the top byte */
+static inline void s_blend32(Uint32 *dst, Uint32 s)
+{
+    Uint32 sa = s >> 24;
+    Uint32 d, da;
+
+    if (sa == 0xFF) {
+        *dst = s;
+    }
+    else if (sa) {
+        d = *dst;
+        da = d >> 24;
+        da = sa + da - ((sa * da + 0xFF) >> 8);
+        *dst = (s_lerp(d, s, sa + (sa >> 7)) & 0x00FFFFFF) | (da << 24);
+    }
+}
+
+static inline void s_put(const warp_surface_t *dst, int x, int y,
+        const warp_surface_t *src, Sint32 sx, Sint32 sy, int bpp, DWORD mode)
+{
+    Uint8 *p = dst->bits + y * dst->pitch;
+
+    if (bpp == 2) {
+        int x0 = MIN(sx >> 16, src->w - 1);
+        int y0 = MIN(sy >> 16, src->h - 1);
+        ((Uint16*)p)[x] = ((const Uint16*)(src->bits + y0 * src->pitch))[x0];
+    }
+    else {
+        Uint32 pixel = s_sample32(src, sx, sy, mode & WARP_FLAG_BILINEAR);
+        if (mode & WARP_BLEND)
+            s_blend32((Uint32*)p + x, pixel);
+        else
+            ((Uint32*)p)[x] = pixel;
+    }
+}
+
+/* rows are the lines: the source row is fixed, the column steps */
+static void s_warpRows(const warp_surface_t *dst, const warp_surface_t *src,
+        const RECT *clip, int from, int to, int bpp, DWORD mode)
+{
+    int y, x;
+
+    for (y = MAX(from, clip->top); y < MIN(to, clip->bottom); y++) {
+        const warp_line_t *line = s_lines + y;
+        int first = MAX(line->first, clip->left);
+        int last = MIN(line->last, clip->right);
+        Sint32 sx;
+
+        if (first >= last)
+            continue;
+        sx = s_across(line, first);
+        for (x = first; x < last; x++) {
+            s_put(dst, x, y, src, sx, line->u, bpp, mode);
+            sx += line->step;
+        }
+    }
+}
+
+/* columns are the lines: walk the destination row by row anyway, each
+ * column carries its running source row */
+static void s_warpColumns(const warp_surface_t *dst, const warp_surface_t *src,
+        const RECT *clip, int from, int to, int bpp, DWORD mode)
+{
+    int y, x;
+
+    from = MAX(from, clip->left);
+    to = MIN(to, clip->right);
+
+    for (x = from; x < to; x++) {
+        warp_line_t *line = s_lines + x;
+        line->first = MAX(line->first, clip->top);
+        line->last = MIN(line->last, clip->bottom);
+        line->v = s_across(line, line->first);
+    }
+
+    for (y = clip->top; y < clip->bottom; y++) {
+        for (x = from; x < to; x++) {
+            warp_line_t *line = s_lines + x;
+
+            if (y < line->first || y >= line->last)
+                continue;
+            s_put(dst, x, y, src, line->u, line->v, bpp, mode);
+            line->v += line->step;
+        }
+    }
+}
+
+BOOL Warp_rotate(HDC dst, HDC src, float angle, int axis, DWORD flags)
+{
+    warp_surface_t s, d;
+    RECT rc, clip;
+    int bpp, from, to, n, m;
+    DWORD mode = flags;
+
+    bpp = GetGDCapability(src, GDCAP_BPP);
+    if (bpp != GetGDCapability(dst, GDCAP_BPP) || (bpp != 2 && bpp != 4))
+        return FALSE;
+
+    /* blend when the source has an alpha channel we know */
+    if (bpp == 4 && GetGDCapability(src, GDCAP_AMASK) == 0xFF000000)
+        mode |= WARP_BLEND;
+
+    s.w = GetGDCapability(src, GDCAP_MAXX) + 1;
+    s.h = GetGDCapability(src, GDCAP_MAXY) + 1;
+    d.w = GetGDCapability(dst, GDCAP_MAXX) + 1;
+    d.h = GetGDCapability(dst, GDCAP_MAXY) + 1;
+
+    /* the card is projected in the box of the source */
+    n = (axis == WARP_AXIS_X) ? s.h : s.w;
+    m = (axis == WARP_AXIS_X) ? s.w : s.h;
+    if (!s_setupLines(n, m, angle, &from, &to))
+        return FALSE;
+
+    GetClipBox(dst, &clip);
+    SetRect(&rc, 0, 0, MIN(s.w, d.w), MIN(s.h, d.h));
+    if (!IntersectRect(&clip, &clip, &rc))
+        return TRUE;
+
+    SetRect(&rc, 0, 0, s.w, s.h);
+    s.bits = LockDC(src, &rc, &s.w, &s.h, &s.pitch);
+    if (s.bits == NULL)
+        return FALSE;
+    SetRect(&rc, 0, 0, d.w, d.h);
+    d.bits = LockDC(dst, &rc, &d.w, &d.h, &d.pitch);
+    if (d.bits == NULL) {
+        UnlockDC(src);
+        return FALSE;
+    }
+
+    if (axis == WARP_AXIS_X)
+        s_warpRows(&d, &s, &clip, from, to, bpp, mode);
+    else
+        s_warpColumns(&d, &s, &clip, from, to, bpp, mode);
+
+    UnlockDC(dst);
+    UnlockDC(src);
+    return TRUE;
+}
+
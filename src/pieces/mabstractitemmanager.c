@@ -65,11 +65,45 @@ static mItemIterator* mAbstractItemManager_createItemIterator(mAbstractItemManag
     return NULL;
 }
 
+/* fallback for managers without a cursor, quadratic but allocation bounded */
+static mPieceItem* s_cursorStep(mAbstractItemManager* self, ITEM_CURSOR* cursor, BOOL forward)
+{
+    mItemIterator *iter = _c(self)->createItemIterator(self);
+    mPieceItem *item = NULL;
+    int i;
+
+    if (NULL == iter)
+        return NULL;
+
+    for (i = 0; i <= cursor->index + 1; ++i) {
+        item = forward ? _c(iter)->next(iter) : _c(iter)->prev(iter);
+        if (NULL == item)
+            break;
+    }
+    DELETE(iter);
+
+    if (item)
+        cursor->index++;
+    return item;
+}
+
+static mPieceItem* mAbstractItemManager_cursorNext(mAbstractItemManager* self, ITEM_CURSOR* cursor)
+{
+    return s_cursorStep(self, cursor, TRUE);
+}
+
+static mPieceItem* mAbstractItemManager_cursorPrev(mAbstractItemManager* self, ITEM_CURSOR* cursor)
+{
+    return s_cursorStep(self, cursor, FALSE);
+}
+
 BEGIN_MINI_CLASS(mAbstractItemManager, mObject)
 	CLASS_METHOD_MAP(mAbstractItemManager, construct)
 	CLASS_METHOD_MAP(mAbstractItemManager, destroy)
 	CLASS_METHOD_MAP(mAbstractItemManager, addItem)
 	CLASS_METHOD_MAP(mAbstractItemManager, removeItem)
 	CLASS_METHOD_MAP(mAbstractItemManager, createItemIterator)
+	CLASS_METHOD_MAP(mAbstractItemManager, cursorNext)
+	CLASS_METHOD_MAP(mAbstractItemManager, cursorPrev)
 END_MINI_CLASS
 
@@ -0,0 +1,268 @@
+/*
+ *   This file is part of mGNCS4Touch, a component for MiniGUI.
+ * 
+ *   Copyright (C) 2008~2018, Beijing FMSoft Technologies Co., Ltd.
+ * 
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ * 
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ * 
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * 
+ *   Or,
+ * 
+ *   As this program is a library, any link to this program must follow
+ *   GNU General Public License version 3 (GPLv3). If you cannot accept
+ *   GPLv3, you need to be licensed from FMSoft.
+ * 
+ *   If you have got a commercial license of this program, please use it
+ *   under the terms and conditions of the commercial license.
+ * 
+ *   For more information about the commercial license, please refer to
+ *   <http://www.minigui.com/en/about/licensing-policy/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <minigui/common.h>
+#include <minigui/minigui.h>
+#include <minigui/gdi.h>
+#include <minigui/window.h>
+
+#include <mgplus/mgplus.h>
+#include <mgeff/mgeff.h>
+#include <mgncs/mgncs.h>
+
+#include "mgncs4touch.h"
+
+#define MIN_SLOTS 8
+
+static void mArrayItemManager_construct(mArrayItemManager *self, DWORD add_data)
+{
+	Class(mAbstractItemManager).construct((mAbstractItemManager*)self, add_data);
+    self->items = NULL;
+    self->nr_slots = 0;
+    self->max_slots = 0;
+    self->nr_items = 0;
+    self->counts = NULL;
+}
+
+static void mArrayItemManager_destroy(mArrayItemManager *self)
+{
+    _c(self)->clear(self);
+    free(self->items);
+    free(self->counts);
+    Class(mAbstractItemManager).destroy((mAbstractItemManager*)self);
+}
+
+/* counts[i] holds the items in the slots (i & (i + 1)) to i */
+static void s_countAdd(mArrayItemManager *self, int slot, int delta)
+{
+    for (; slot < self->max_slots; slot |= slot + 1)
+        self->counts[slot] += delta;
+}
+
+/* items in the slots before slot */
+static int s_countBefore(mArrayItemManager *self, int slot)
+{
+    int n = 0;
+
+    for (--slot; slot >= 0; slot = (slot & (slot + 1)) - 1)
+        n += self->counts[slot];
+    return n;
+}
+
+/* slot of the item at index, index < nr_items */
+static int s_findSlot(mArrayItemManager *self, int index)
+{
+    int slot = 0, step = 1;
+
+    while (step * 2 <= self->max_slots)
+        step *= 2;
+    /* slot ends up as the number of slots in front of the item */
+    for (; step > 0; step >>= 1) {
+        if (slot + step <= self->max_slots && self->counts[slot + step - 1] <= index) {
+            slot += step;
+            index -= self->counts[slot - 1];
+        }
+    }
+    return slot;
+}
+
+static void s_countRebuild(mArrayItemManager *self)
+{
+    int i;
+
+    for (i = 0; i < self->max_slots; ++i)
+        self->counts[i] = (i < self->nr_slots && self->items[i]) ? 1 : 0;
+    for (i = 0; i < self->max_slots; ++i) {
+        int parent = i | (i + 1);
+        if (parent < self->max_slots)
+            self->counts[parent] += self->counts[i];
+    }
+}
+
+/* squeeze the holes left by removeItem out, keeping the order */
+static void s_compact(mArrayItemManager *self)
+{
+    int i, n = 0;
+
+    if (self->nr_items == self->nr_slots)
+        return;
+
+    for (i = 0; i < self->nr_slots; ++i) {
+        mPieceItem *item = self->items[i];
+        if (item) {
+            item->index = n;
+            self->items[n++] = item;
+        }
+    }
+    self->nr_slots = n;
+    s_countRebuild(self);
+}
+
+static int mArrayItemManager_addItem(mArrayItemManager* self, mPieceItem* item)
+{
+    if (NULL == item)
+        return -1;
+
+    if (self->nr_slots == self->max_slots) {
+        /* reuse the holes once they make half of the slots */
+        if (self->nr_slots > 0 && self->nr_items <= self->nr_slots / 2) {
+            s_compact(self);
+        }
+        else {
+            int max = self->max_slots ? self->max_slots * 2 : MIN_SLOTS;
+            mPieceItem **items = (mPieceItem**)realloc(self->items, max * sizeof(mPieceItem*));
+            int *counts;
+            if (NULL == items)
+                return -1;
+            self->items = items;
+            counts = (int*)realloc(self->counts, max * sizeof(int));
+            if (NULL == counts)
+                return -1;
+            self->counts = counts;
+            self->max_slots = max;
+            s_countRebuild(self);
+        }
+    }
+
+    item->index = self->nr_slots;
+    self->items[self->nr_slots++] = item;
+    self->nr_items++;
+    s_countAdd(self, item->index, 1);
+    return 0;
+}
+
+static void mArrayItemManager_removeItem(mArrayItemManager* self, mPieceItem* item)
+{
+    if (NULL == item || item->index < 0 || item->index >= self->nr_slots
+            || self->items[item->index] != item)
+        return;
+
+    self->items[item->index] = NULL;
+    s_countAdd(self, item->index, -1);
+    item->index = -1;
+    if (--self->nr_items == 0)
+        self->nr_slots = 0;
+}
+
+static void mArrayItemManager_clear(mArrayItemManager* self)
+{
+    int i;
+
+    for (i = 0; i < self->nr_slots; ++i) {
+        if (self->items[i])
+            self->items[i]->index = -1;
+    }
+    if (self->counts)
+        memset(self->counts, 0, self->max_slots * sizeof(int));
+    self->nr_slots = 0;
+    self->nr_items = 0;
+}
+
+static mItemIterator* mArrayItemManager_createItemIterator(mArrayItemManager* self)
+{
+    mArrayItemIterator* iter = NEW(mArrayItemIterator);
+    if (NULL != iter) {
+        iter->current = -1;
+        iter->manager = (mAbstractItemManager*)self;
+        return (mItemIterator*)iter;
+    }
+    return NULL;
+}
+
+static mPieceItem* mArrayItemManager_cursorNext(mArrayItemManager* self, ITEM_CURSOR* cursor)
+{
+    int i;
+
+    for (i = cursor->index + 1; i < self->nr_slots; ++i) {
+        if (self->items[i]) {
+            cursor->index = i;
+            return self->items[i];
+        }
+    }
+    return NULL;
+}
+
+static mPieceItem* mArrayItemManager_cursorPrev(mArrayItemManager* self, ITEM_CURSOR* cursor)
+{
+    int i = cursor->pos ? cursor->index : self->nr_slots;
+
+    /* pos only tells a fresh cursor from one at slot 0 */
+    cursor->pos = self;
+    while (--i >= 0) {
+        if (self->items[i]) {
+            cursor->index = i;
+            return self->items[i];
+        }
+    }
+    cursor->index = 0;
+    return NULL;
+}
+
+static mPieceItem* mArrayItemManager_itemAt(mArrayItemManager* self, int index)
+{
+    if (index < 0 || index >= self->nr_items)
+        return NULL;
+    if (self->nr_items == self->nr_slots)
+        return self->items[index];
+    return self->items[s_findSlot(self, index)];
+}
+
+static int mArrayItemManager_indexOf(mArrayItemManager* self, mPieceItem* item)
+{
+    if (NULL == item || item->index < 0 || item->index >= self->nr_slots
+            || self->items[item->index] != item)
+        return -1;
+
+    if (self->nr_items == self->nr_slots)
+        return item->index;
+    return s_countBefore(self, item->index);
+}
+
+static int mArrayItemManager_getCount(mArrayItemManager* self)
+{
+    return self->nr_items;
+}
+
+BEGIN_MINI_CLASS(mArrayItemManager, mAbstractItemManager)
+	CLASS_METHOD_MAP(mArrayItemManager, construct)
+	CLASS_METHOD_MAP(mArrayItemManager, destroy)
+	CLASS_METHOD_MAP(mArrayItemManager, addItem)
+	CLASS_METHOD_MAP(mArrayItemManager, removeItem)
+	CLASS_METHOD_MAP(mArrayItemManager, clear)
+	CLASS_METHOD_MAP(mArrayItemManager, createItemIterator)
+	CLASS_METHOD_MAP(mArrayItemManager, cursorNext)
+	CLASS_METHOD_MAP(mArrayItemManager, cursorPrev)
+	CLASS_METHOD_MAP(mArrayItemManager, itemAt)
+	CLASS_METHOD_MAP(mArrayItemManager, indexOf)
+	CLASS_METHOD_MAP(mArrayItemManager, getCount)
+END_MINI_CLASS
@@ -66,56 +66,37 @@ static void mGroupItemIterator_destroy(mGroupItemIterator *self)
     }
 }
 
-static mPieceItem*  mGroupItemIterator_next(mGroupItemIterator* self)
+/* head/current walk the children of the current group, no child iterator */
+static mPieceItem* s_step(mGroupItemIterator* self, BOOL forward)
 {
     mPieceItem* item = NULL;
 
-    if (self->childIter == NULL) {
-        if ((item = _c(self->parentIter)->next(self->parentIter))) {
-            self->childIter = (mListItemIterator*)NEW(mListItemIterator);
-            self->childIter->current = self->childIter->head = &((mGroupPieceItem*)item)->child;
-            self->manager = (mAbstractItemManager*)self->parentIter->manager;
+    if (self->head) {
+        list_t* node = forward ? self->current->next : self->current->prev;
+        if (node != self->head) {
+            self->current = node;
+            return ITEM_HEAD(node);
         }
+        self->head = self->current = NULL;
     }
-    else {
-        item = _c(self->childIter)->next(self->childIter);
-        if (item == NULL)  {
-            DELETE(self->childIter);
-            self->childIter = NULL;
-            if ((item = _c(self->parentIter)->next(self->parentIter))) {
-                self->childIter = (mListItemIterator*)NEW(mListItemIterator);
-                self->childIter->current = self->childIter->head = &((mGroupPieceItem*)item)->child;
-                self->manager = (mAbstractItemManager*)self->parentIter->manager;
-            }
-        }
+
+    item = forward ? _c(self->parentIter)->next(self->parentIter)
+        : _c(self->parentIter)->prev(self->parentIter);
+    if (item) {
+        self->current = self->head = &((mGroupPieceItem*)item)->child;
+        self->manager = (mAbstractItemManager*)self->parentIter->manager;
     }
     return item;
 }
 
-static mPieceItem*  mGroupItemIterator_prev(mGroupItemIterator* self)
+static mPieceItem*  mGroupItemIterator_next(mGroupItemIterator* self)
 {
-    mPieceItem* item = NULL;
+    return s_step(self, TRUE);
+}
 
-    if (self->childIter == NULL) {
-        if ((item = _c(self->parentIter)->prev(self->parentIter))) {
-            self->childIter = (mListItemIterator*)NEW(mListItemIterator);
-            self->childIter->current = self->childIter->head = &((mGroupPieceItem*)item)->child;
-            self->manager = (mAbstractItemManager*)self->parentIter->manager;
-        }
-    }
-    else {
-        item = _c(self->childIter)->prev(self->childIter);
-        if (item == NULL)  {
-            DELETE(self->childIter);
-            self->childIter = NULL;
-            if ((item = _c(self->parentIter)->prev(self->parentIter))) {
-                self->childIter = (mListItemIterator*)NEW(mListItemIterator);
-                self->childIter->current = self->childIter->head = &((mGroupPieceItem*)item)->child;
-                self->manager = (mAbstractItemManager*)self->parentIter->manager;
-            }
-        }
-    }
-    return item;
+static mPieceItem*  mGroupItemIterator_prev(mGroupItemIterator* self)
+{
+    return s_step(self, FALSE);
 }
 
 static mGroupItemIterator* mGroupItemIterator_duplicate(mGroupItemIterator* self)
@@ -123,9 +104,8 @@ static mGroupItemIterator* mGroupItemIterator_duplicate(mGroupItemIterator* self
     mGroupItemIterator* iter = (mGroupItemIterator*)NEWEX(mGroupItemIterator, (DWORD)self->key);
     if (NULL != iter) {
         iter->parentIter = (mListItemIterator*)_c(self->parentIter)->duplicate(self->parentIter);
-        if (self->childIter) {
-            iter->childIter = (mListItemIterator*)_c(self->childIter)->duplicate(self->childIter);
-        }
+        iter->head = self->head;
+        iter->current = self->current;
         iter->manager = (mAbstractItemManager*)self->manager;
         return iter;
     }
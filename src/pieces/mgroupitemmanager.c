@@ -29,6 +29,7 @@
  *   <http://www.minigui.com/en/about/licensing-policy/>.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <minigui/common.h>
@@ -42,7 +43,7 @@
 
 #include "mgncs4touch.h"
 
-#define ITEM_HEAD(ptr, list) list_entry(ptr, mGroupPieceItem, list)
+#define MIN_KEYS 8
 
 static void mGroupItemManager_construct(mGroupItemManager *self, DWORD add_data)
 {
@@ -50,135 +51,422 @@ static void mGroupItemManager_construct(mGroupItemManager *self, DWORD add_data)
 
     INIT_LIST_HEAD(&self->itemList);
     self->itemCmp = strcmp;
+    self->groups = NULL;
+    self->nr_groups = 0;
+    self->max_groups = 0;
 }
 
 static void mGroupItemManager_destroy(mGroupItemManager *self)
 {
+    _c(self)->clear(self);
+    free(self->groups);
     Class(mAbstractItemManager).destroy((mAbstractItemManager*)self);
 }
 
+/* index of the first entry not less than key, GROUP_KEY leads every entry */
+static int s_lowerBound(const void* base, int n, size_t size, const char* key, ITEM_CMP cmp)
+{
+    int lo = 0, hi = n;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        const GROUP_KEY* k = (const GROUP_KEY*)((const char*)base + mid * size);
+        if (cmp(k->key, key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* grows the array to hold need entries, returns NULL and keeps it on failure */
+static void* s_reserve(void* base, int* max, int need, size_t size)
+{
+    int m;
+
+    if (need <= *max)
+        return base;
+
+    m = *max ? *max : MIN_KEYS;
+    while (m < need)
+        m *= 2;
+    if ((base = realloc(base, m * size)))
+        *max = m;
+    return base;
+}
+
+/* stable bottom-up merge sort, tmp holds n keys */
+static void s_sortKeys(GROUP_KEY* keys, GROUP_KEY* tmp, int n, ITEM_CMP cmp)
+{
+    GROUP_KEY *src = keys, *dst = tmp, *t;
+    int width;
+
+    for (width = 1; width < n; width *= 2) {
+        int lo;
+        for (lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+                dst[k++] = cmp(src[i].key, src[j].key) <= 0 ? src[i++] : src[j++];
+            while (i < mid)
+                dst[k++] = src[i++];
+            while (j < hi)
+                dst[k++] = src[j++];
+        }
+        t = src; src = dst; dst = t;
+    }
+    if (src != keys)
+        memcpy(keys, src, n * sizeof(GROUP_KEY));
+}
+
+static int s_findGroup(mGroupItemManager* self, const char* key)
+{
+    int i = s_lowerBound(self->groups, self->nr_groups, sizeof(GROUP_SLOT), key, self->itemCmp);
+    if (i < self->nr_groups && self->itemCmp(self->groups[i].group.key, key) == 0)
+        return i;
+    return -1;
+}
+
+/* first key char is group key. */
+static GROUP_SLOT* s_groupOf(mGroupItemManager* self, const char* key)
+{
+    char group[2];
+    int i;
+
+    group[0] = key[0];
+    group[1] = '\0';
+    i = s_findGroup(self, group);
+    return i < 0 ? NULL : &self->groups[i];
+}
+
+static void s_unlinkChildren(GROUP_SLOT* slot)
+{
+    int i;
+
+    for (i = 0; i < slot->nr_children; ++i) {
+        list_del(&slot->children[i].item->list);
+    }
+    INIT_LIST_HEAD(&slot->group.item->child);
+    free(slot->children);
+    slot->children = NULL;
+    slot->nr_children = slot->max_children = 0;
+}
 
 BOOL mGroupItemManager_addGroupItem(mGroupItemManager* self, mGroupPieceItem* item, BOOL group)
 {
-    BOOL ret = FALSE;
-    mGroupPieceItem* s = NULL;
+    const char* key = _c(item)->getKey(item);
+    GROUP_SLOT* slot;
+    int i;
+
     if (group) {
-        if (list_empty(&self->itemList)) {
-            list_add(&(item->list), &self->itemList);
-            INIT_LIST_HEAD(&item->child);
-            ret = TRUE;
+        GROUP_SLOT* groups;
+
+        /* only intert one group item. */
+        i = s_lowerBound(self->groups, self->nr_groups, sizeof(GROUP_SLOT), key, self->itemCmp);
+        if (i < self->nr_groups && self->itemCmp(self->groups[i].group.key, key) == 0)
+            return FALSE;
+
+        groups = s_reserve(self->groups, &self->max_groups, self->nr_groups + 1, sizeof(GROUP_SLOT));
+        if (NULL == groups)
+            return FALSE;
+        self->groups = groups;
+
+        memmove(&groups[i + 1], &groups[i], (self->nr_groups - i) * sizeof(GROUP_SLOT));
+        self->nr_groups++;
+        slot = &groups[i];
+        slot->group.key = key;
+        slot->group.item = item;
+        slot->children = NULL;
+        slot->nr_children = slot->max_children = 0;
+
+        INIT_LIST_HEAD(&item->child);
+        if (i + 1 < self->nr_groups) {
+            /* add to before of the next group.*/
+            list_add_tail(&(item->list), &groups[i + 1].group.item->list);
         }
         else {
-            /* only intert one group item. */
-            s = _c(self)->searchGroupItem(self, _c(item)->getKey(item), group);
-            if (!s) {
-                s = _c(self)->searchGreaterGroupItem(self, _c(item)->getKey(item), group);
-                if (!s) {
-                    /* add to tail.*/
-                    list_add_tail(&(item->list), &self->itemList);
-                }
-                else {
-                    /* add to before of search group.*/
-                    list_add_tail(&(item->list), &s->list);
-                }
-                INIT_LIST_HEAD(&item->child);
-                ret = TRUE;
-            }
+            list_add_tail(&(item->list), &self->itemList);
         }
     }
     else  {
-        s = _c(self)->searchGreaterGroupItem(self, _c(item)->getKey(item), FALSE);
-        if (s) {
-            /* add to before of get grout item(s->list). */
-            list_add_tail(&(item->list), &s->list);
+        GROUP_KEY* children;
+
+        if (NULL == (slot = s_groupOf(self, key)))
+            return FALSE;
+
+        i = s_lowerBound(slot->children, slot->nr_children, sizeof(GROUP_KEY), key, self->itemCmp);
+        children = s_reserve(slot->children, &slot->max_children, slot->nr_children + 1, sizeof(GROUP_KEY));
+        if (NULL == children)
+            return FALSE;
+        slot->children = children;
+
+        memmove(&children[i + 1], &children[i], (slot->nr_children - i) * sizeof(GROUP_KEY));
+        slot->nr_children++;
+        children[i].key = key;
+        children[i].item = item;
+
+        if (i + 1 < slot->nr_children) {
+            /* add to before of the greater child. */
+            list_add_tail(&(item->list), &children[i + 1].item->list);
         }
         else {
-            char* key = _c(item)->getKey(item);
-            char group[2];
-            group[0] = key[0]; 
-            group[1] = '\0';
-            s = _c(self)->searchGroupItem(self, group, TRUE);
-            list_add_tail(&(item->list), &s->child);
+            list_add_tail(&(item->list), &slot->group.item->child);
         }
-        ret = TRUE;
     }
-    return ret;
+    return TRUE;
 }
 
-mGroupPieceItem* mGroupItemManager_searchGreaterGroupItem(mGroupItemManager* self, const char* key, BOOL group)
+static int s_addGroups(mGroupItemManager* self, GROUP_KEY* keys, int n)
 {
-    list_t* i;
-    mGroupPieceItem* ret = NULL;
-    if (group) {   
-        list_for_each(i, &self->itemList) {
-            mGroupPieceItem* c = (mGroupPieceItem*)ITEM_HEAD(i, list);
-            if (self->itemCmp(_c(c)->getKey(c), key) >= 0) {
-                ret  = c ;
-                break;
-            }
+    GROUP_SLOT* merged = (GROUP_SLOT*)malloc((self->nr_groups + n) * sizeof(GROUP_SLOT));
+    int i = 0, j = 0, nr = 0, added = 0;
+
+    if (NULL == merged)
+        return 0;
+
+    while (i < self->nr_groups || j < n) {
+        if (j >= n || (i < self->nr_groups
+                    && self->itemCmp(self->groups[i].group.key, keys[j].key) <= 0)) {
+            merged[nr++] = self->groups[i++];
         }
-    }
-    else {
-        /* first key char is group key. */
-        char group[2];
-        mGroupPieceItem* g_item;
-        group[0] = key[0]; 
-        group[1] = '\0';
-        g_item = _c(self)->searchGroupItem(self, group, TRUE);
-        if (g_item) {
-            list_for_each(i, &g_item->child) {
-                mGroupPieceItem* c = (mGroupPieceItem*)ITEM_HEAD(i, list);
-                if (self->itemCmp(_c(c)->getKey(c), key) >= 0) {
-                    ret  = c ;
-                    break;
-                }
+        else {
+            /* drop the groups already there */
+            if (nr == 0 || self->itemCmp(merged[nr - 1].group.key, keys[j].key) != 0) {
+                GROUP_SLOT* slot = &merged[nr++];
+                slot->group = keys[j];
+                slot->children = NULL;
+                slot->nr_children = slot->max_children = 0;
+                INIT_LIST_HEAD(&keys[j].item->child);
+                added++;
             }
+            j++;
         }
     }
-    return ret;
-}
 
+    free(self->groups);
+    self->groups = merged;
+    self->max_groups = self->nr_groups + n;
+    self->nr_groups = nr;
 
-mGroupPieceItem* mGroupItemManager_searchGroupItem(mGroupItemManager* self, const char* key, BOOL group)
+    INIT_LIST_HEAD(&self->itemList);
+    for (i = 0; i < nr; ++i) {
+        list_add_tail(&merged[i].group.item->list, &self->itemList);
+    }
+    return added;
+}
+
+static int s_addChildren(mGroupItemManager* self, GROUP_KEY* keys, GROUP_KEY* tmp, int n)
 {
-    list_t* i;
-    mGroupPieceItem* ret = NULL;
-    if (group) {   
-        list_for_each(i, &self->itemList) {
-            mGroupPieceItem* c = (mGroupPieceItem*)ITEM_HEAD(i, list);
-            if (self->itemCmp(key, _c(c)->getKey(c)) == 0) {
-                ret  = c ;
-                break;
-            }
+    int *owner, *offs;
+    int i, added = 0;
+
+    owner = (int*)malloc((n + self->nr_groups + 1) * sizeof(int));
+    if (NULL == owner)
+        return 0;
+    offs = owner + n;
+    memset(offs, 0, (self->nr_groups + 1) * sizeof(int));
+
+    for (i = 0; i < n; ++i) {
+        GROUP_SLOT* slot;
+        if (i > 0 && keys[i].key[0] == keys[i - 1].key[0]) {
+            owner[i] = owner[i - 1];
+        }
+        else {
+            slot = s_groupOf(self, keys[i].key);
+            owner[i] = slot ? slot - self->groups : -1;
         }
+        if (owner[i] >= 0)
+            offs[owner[i] + 1]++;
     }
-    else {
-        /* first key char is group key. */
-        char group[2];
-        group[0] = key[0]; 
-        group[1] = '\0';
-        ret = _c(self)->searchGroupItem(self, group, TRUE);
-        if (ret) {
-            list_for_each(i, &ret->list) {
-                mGroupPieceItem* c = (mGroupPieceItem*)ITEM_HEAD(i, list);
-                if (self->itemCmp(key, _c(c)->getKey(c)) == 0) {
-                    ret  = c ;
-                    break;
-                }
-            }
+
+    /* bucket the sorted keys by group, keeping their order */
+    for (i = 0; i < self->nr_groups; ++i) {
+        offs[i + 1] += offs[i];
+    }
+    for (i = 0; i < n; ++i) {
+        if (owner[i] >= 0)
+            tmp[offs[owner[i]]++] = keys[i];
+    }
+
+    for (i = 0; i < self->nr_groups; ++i) {
+        GROUP_SLOT* slot = &self->groups[i];
+        int first = i > 0 ? offs[i - 1] : 0;
+        int c = offs[i] - first;
+        GROUP_KEY* children;
+        int k, o;
+
+        if (c == 0)
+            continue;
+
+        children = s_reserve(slot->children, &slot->max_children, slot->nr_children + c, sizeof(GROUP_KEY));
+        if (NULL == children)
+            continue;
+        slot->children = children;
+
+        /* merge from the back */
+        o = slot->nr_children - 1;
+        k = slot->nr_children + c - 1;
+        while (--c >= 0) {
+            while (o >= 0 && self->itemCmp(children[o].key, tmp[first + c].key) > 0)
+                children[k--] = children[o--];
+            children[k--] = tmp[first + c];
+        }
+        added += offs[i] - first;
+        slot->nr_children += offs[i] - first;
+
+        INIT_LIST_HEAD(&slot->group.item->child);
+        for (k = 0; k < slot->nr_children; ++k) {
+            list_add_tail(&children[k].item->list, &slot->group.item->child);
         }
     }
-    return ret;
+
+    free(owner);
+    return added;
+}
+
+int mGroupItemManager_addGroupItems(mGroupItemManager* self, mGroupPieceItem** items, int n, BOOL group)
+{
+    GROUP_KEY* keys;
+    int i, added;
+
+    if (NULL == items || n <= 0)
+        return 0;
+
+    keys = (GROUP_KEY*)malloc(2 * n * sizeof(GROUP_KEY));
+    if (NULL == keys)
+        return 0;
+
+    for (i = 0; i < n; ++i) {
+        keys[i].key = _c(items[i])->getKey(items[i]);
+        keys[i].item = items[i];
+    }
+    s_sortKeys(keys, keys + n, n, self->itemCmp);
+
+    if (group)
+        added = s_addGroups(self, keys, n);
+    else
+        added = s_addChildren(self, keys, keys + n, n);
+
+    free(keys);
+    return added;
+}
+
+mGroupPieceItem* mGroupItemManager_searchGreaterGroupItem(mGroupItemManager* self, const char* key, BOOL group)
+{
+    GROUP_SLOT* slot;
+    int i;
+
+    if (group) {
+        i = s_lowerBound(self->groups, self->nr_groups, sizeof(GROUP_SLOT), key, self->itemCmp);
+        return i < self->nr_groups ? self->groups[i].group.item : NULL;
+    }
+
+    if (NULL == (slot = s_groupOf(self, key)))
+        return NULL;
+    i = s_lowerBound(slot->children, slot->nr_children, sizeof(GROUP_KEY), key, self->itemCmp);
+    return i < slot->nr_children ? slot->children[i].item : NULL;
+}
+
+
+mGroupPieceItem* mGroupItemManager_searchGroupItem(mGroupItemManager* self, const char* key, BOOL group)
+{
+    GROUP_SLOT* slot;
+    int i;
+
+    if (group) {
+        i = s_findGroup(self, key);
+        return i < 0 ? NULL : self->groups[i].group.item;
+    }
+
+    if (NULL == (slot = s_groupOf(self, key)))
+        return NULL;
+    i = s_lowerBound(slot->children, slot->nr_children, sizeof(GROUP_KEY), key, self->itemCmp);
+    if (i < slot->nr_children && self->itemCmp(slot->children[i].key, key) == 0)
+        return slot->children[i].item;
+    return NULL;
 }
 
 BOOL mGroupItemManager_removeGroupItem(mGroupItemManager* self, const char* key, BOOL group)
 {
+    GROUP_SLOT* slot;
+    int i;
+
+    if (group) {
+        /* the children go along with their group */
+        if ((i = s_findGroup(self, key)) < 0)
+            return FALSE;
+        slot = &self->groups[i];
+        s_unlinkChildren(slot);
+        list_del(&slot->group.item->list);
+        memmove(slot, slot + 1, (self->nr_groups - i - 1) * sizeof(GROUP_SLOT));
+        self->nr_groups--;
+        return TRUE;
+    }
+
+    if (NULL == (slot = s_groupOf(self, key)))
+        return FALSE;
+    i = s_lowerBound(slot->children, slot->nr_children, sizeof(GROUP_KEY), key, self->itemCmp);
+    if (i >= slot->nr_children || self->itemCmp(slot->children[i].key, key) != 0)
+        return FALSE;
+    list_del(&slot->children[i].item->list);
+    memmove(&slot->children[i], &slot->children[i + 1],
+            (slot->nr_children - i - 1) * sizeof(GROUP_KEY));
+    slot->nr_children--;
     return TRUE;
 }
 
 void mGroupItemManager_clear(mGroupItemManager* self)
 {
-    return;
+    int i;
+
+    for (i = 0; i < self->nr_groups; ++i) {
+        s_unlinkChildren(&self->groups[i]);
+        list_del(&self->groups[i].group.item->list);
+    }
+    self->nr_groups = 0;
+    INIT_LIST_HEAD(&self->itemList);
+}
+
+#define GROUP_HEAD(ptr) list_entry(ptr, mGroupPieceItem, list)
+
+/* same order as mGroupItemIterator: a group, then its children */
+static mPieceItem* s_cursorStep(mGroupItemManager* self, ITEM_CURSOR* cursor, BOOL forward)
+{
+    list_t *group = (list_t*)cursor->pos;
+    list_t *child, *head;
+
+    if (group) {
+        head = &GROUP_HEAD(group)->child;
+        if (cursor->next)
+            child = forward ? ((list_t*)cursor->next)->next : ((list_t*)cursor->next)->prev;
+        else
+            child = forward ? head->next : head->prev;
+        if (child != head) {
+            cursor->next = child;
+            return list_entry(child, mPieceItem, list);
+        }
+    }
+    else {
+        group = &self->itemList;
+    }
+
+    group = forward ? group->next : group->prev;
+    if (group == &self->itemList)
+        return NULL;
+    cursor->pos = group;
+    cursor->next = NULL;
+    return (mPieceItem*)GROUP_HEAD(group);
+}
+
+static mPieceItem* mGroupItemManager_cursorNext(mGroupItemManager* self, ITEM_CURSOR* cursor)
+{
+    return s_cursorStep(self, cursor, TRUE);
+}
+
+static mPieceItem* mGroupItemManager_cursorPrev(mGroupItemManager* self, ITEM_CURSOR* cursor)
+{
+    return s_cursorStep(self, cursor, FALSE);
 }
 
 mItemIterator* mGroupItemManager_createItemIterator(mGroupItemManager* self)
@@ -210,9 +498,12 @@ BEGIN_MINI_CLASS(mGroupItemManager, mAbstractItemManager)
 	CLASS_METHOD_MAP(mGroupItemManager, searchGroupItem)
 	CLASS_METHOD_MAP(mGroupItemManager, searchGreaterGroupItem)
 	CLASS_METHOD_MAP(mGroupItemManager, addGroupItem)
+	CLASS_METHOD_MAP(mGroupItemManager, addGroupItems)
 	CLASS_METHOD_MAP(mGroupItemManager, removeGroupItem)
 	CLASS_METHOD_MAP(mGroupItemManager, clear)
 	CLASS_METHOD_MAP(mGroupItemManager, createItemIterator)
 	CLASS_METHOD_MAP(mGroupItemManager, createGroupItemIterator)
+	CLASS_METHOD_MAP(mGroupItemManager, cursorNext)
+	CLASS_METHOD_MAP(mGroupItemManager, cursorPrev)
 END_MINI_CLASS
 
@@ -70,6 +70,7 @@ void mListItemManager_removeItem(mListItemManager* self, mPieceItem* item)
         list_for_each_safe(pos, n, &self->queue) {
             if (pos == &item->list) {
                 list_del(pos);
+                break;
             }
         }
     }
@@ -94,6 +95,30 @@ mItemIterator* mListItemManager_createItemIterator(mListItemManager* self)
     return NULL;
 }
 
+#define ITEM_HEAD(ptr) list_entry(ptr, mPieceItem, list)
+
+static mPieceItem* mListItemManager_cursorNext(mListItemManager* self, ITEM_CURSOR* cursor)
+{
+    list_t *node = cursor->pos ? (list_t*)cursor->next : self->queue.next;
+
+    if (node == &self->queue)
+        return NULL;
+    cursor->pos = node;
+    cursor->next = node->next;
+    return ITEM_HEAD(node);
+}
+
+static mPieceItem* mListItemManager_cursorPrev(mListItemManager* self, ITEM_CURSOR* cursor)
+{
+    list_t *node = cursor->pos ? (list_t*)cursor->next : self->queue.prev;
+
+    if (node == &self->queue)
+        return NULL;
+    cursor->pos = node;
+    cursor->next = node->prev;
+    return ITEM_HEAD(node);
+}
+
 BEGIN_MINI_CLASS(mListItemManager, mAbstractItemManager)
 	CLASS_METHOD_MAP(mListItemManager, construct)
 	CLASS_METHOD_MAP(mListItemManager, destroy)
@@ -101,5 +126,7 @@ BEGIN_MINI_CLASS(mListItemManager, mAbstractItemManager)
 	CLASS_METHOD_MAP(mListItemManager, removeItem)
 	CLASS_METHOD_MAP(mListItemManager, clear)
 	CLASS_METHOD_MAP(mListItemManager, createItemIterator)
+	CLASS_METHOD_MAP(mListItemManager, cursorNext)
+	CLASS_METHOD_MAP(mListItemManager, cursorPrev)
 END_MINI_CLASS
 
@@ -42,67 +42,9 @@
 
 #include "mgncs4touch.h"
 
-#define HAVE_H_FILLLADDER
 #define ROTATE_90 90
 #define HOVER
 
-typedef struct _TransAffine_3D
-{
-    double m[12]; //World TransForm;
-}TransAffine3D;
-
-typedef struct _Vector3D
-{
-    int x;
-    int y;
-    int z;
-}Vector3D;
-
-typedef struct _Vector2D
-{
-    int x;
-    int y;
-}Vector2D;
-
-#ifdef HAVE_H_FILLLADDER
-extern void effcommon_v_fillladder(HDC src_dc, int src_left, int src_top, int src_right, int src_bottom,
-        HDC dst_dc, int dst_left, int dst_top, int dst_right, int dst_bottom,
-        int dst_x0, int dst_y0,
-        int dst_x1, int dst_y1,
-        int dst_x2, int dst_y2,
-        int dst_x3, int dst_y3);
-extern void effcommon_h_fillladder(HDC src_dc, int src_left, int src_top, int src_right, int src_bottom,
-        HDC dst_dc, int dst_left, int dst_top, int dst_right, int dst_bottom,
-        int dst_x0, int dst_y0,
-        int dst_x1, int dst_y1,
-        int dst_x2, int dst_y2,
-        int dst_x3, int dst_y3);
-#else
-extern void effcommon_fillladder(HDC src_dc, int src_left, int src_top, int src_right, int src_bottom,
-        HDC dst_dc, int dst_left, int dst_top, int dst_right, int dst_bottom,
-        int dst_x0, int dst_y0,
-        int dst_x1, int dst_y1,
-        int dst_x2, int dst_y2,
-        int dst_x3, int dst_y3);
-#endif
-extern TransAffine3D* Init3DSenceTransAffine (void);
-extern int MatrixMultiply (double* A, double* B, double* C);
-extern int Set3DPointOfView (TransAffine3D* pTrans, double dXMove, double dYMove, double dZMove);
-extern int Scale3DSence (TransAffine3D* pTrans, double x, double y, double z);
-extern int Move3DSence (TransAffine3D* pTrans, double x, double y, double z);
-extern int Roll3DSence (TransAffine3D* pTrans, double dZAngle);
-extern int RotateHoriz3DSence (TransAffine3D* pTrans, double dYAngle);
-extern int RotateVertical3DSence (TransAffine3D* pTrans, double dXAngle);
-extern int Generate3DPointBy3DSence (TransAffine3D* pTrans, Vector3D* pVector);
-extern void Terminate3DSenceTransAffine (TransAffine3D* pTransAffine);
-extern int Perspective3DTo2D (Vector3D* pVector3D, Vector2D* pVector2D, int nPerspectiveZ, int nXCenter, int nYCenter);
-extern int Reset3DSenceTransAffine (TransAffine3D* pTransAffine);
-
-
-#ifdef ENABLE_ANIM_FPS_TEST
-    extern void anim_fps_test_start (int new_status);
-#endif
-
 
 int s_totalObjRef = 0;
 int s_totalPieceRef = 0;
@@ -115,177 +57,24 @@ static void getRectFromDC(HDC hdc, RECT *prc)
     prc->bottom = GetGDCapability(hdc, GDCAP_MAXY) + 1;
 }
 
-static void rotate(HDC dst_dc, HDC src_dc, mNormalVector *mv)
+/* rect of the child in the coordinates of its panel */
+static void s_getItemRect(mPieceItem *item, RECT *prc)
 {
-    int w, h, nZprep;
-    int i;
-    TransAffine3D *pTransAffine = NULL;
-    Vector3D Points3D[2];
-    Vector2D Points2D[2];
-    POINTF   Points[4];
-    double dAngle;
-    RECT rc;
+    if (_c(item->piece)->getRect(item->piece, prc) < 0) {
+        SetRectEmpty(prc);
+        return;
+    }
+    OffsetRect(prc, item->x, item->y);
+}
 
+static void rotate(HDC dst_dc, HDC src_dc, mNormalVector *mv, DWORD flags)
+{
     if (dst_dc != HDC_INVALID && src_dc != HDC_INVALID) {
         assert(mv->angle >= 0.0 && mv->angle <= 180.0);
-        dAngle = ROTATE_90 - mv->angle;
-        if (dAngle > 0)
-            dAngle -= ROTATE_90;
-        else
-            dAngle += ROTATE_90;
-
-        getRectFromDC(src_dc, &rc);
-        w = RECTW(rc);
-        h = RECTH(rc);
-        nZprep = 3 * w;
-        pTransAffine = Init3DSenceTransAffine();
-
-        if (!pTransAffine) {
-            _ERR_PRINTF ("mGNCS4Touch>rotate: [3D Sence] can not malloc enough memory!");
-            return;
-        }
-
-        if (mv->x) {
-#ifdef HAVE_H_FILLLADDER
-            Points3D[0].x = w;
-            Points3D[0].y = - h / 2;
-            Points3D[0].z = 0;
-
-            Points3D[1].x = w;
-            Points3D[1].y = (h + 1) / 2;
-            Points3D[1].z = 0;
-
-            Set3DPointOfView(pTransAffine, 0, 0, 0);
-            RotateVertical3DSence(pTransAffine, dAngle);
-            for (i = 0; i < 2; ++i) {
-                Generate3DPointBy3DSence(pTransAffine, &Points3D[i]);
-                Perspective3DTo2D(&Points3D[i], &Points2D[i], nZprep, 0, 0);
-            }
-            Terminate3DSenceTransAffine (pTransAffine);
-
-            Points[0].xf = Points2D[0].x;
-            Points[0].yf = Points2D[0].y + h / 2;
-
-            Points[1].xf = Points2D[1].x;
-            Points[1].yf = Points2D[1].y + h / 2;
-
-            Points[3].xf = w - Points2D[0].x;
-            Points[3].yf = Points2D[0].y + h / 2;
-
-            Points[2].xf = w - Points2D[1].x;
-            Points[2].yf = Points2D[1].y + h / 2;
-
-            if (Points[0].xf != w && Points[1].xf != w) {
-                double scale;
-                if (Points[0].xf > w) {
-                    scale = (float)w / Points[0].xf;
-                    Points[0].xf = w;
-                    Points[3].xf = 0;
-                    Points[2].xf = w / 2 - scale * (w / 2 - Points[2].xf);
-                    Points[1].xf = w - Points[2].xf;
-
-                } else {
-                    scale = (float)w / Points[1].xf;
-                    Points[3].xf = w / 2 - scale * (w / 2 - Points[3].xf);
-                    Points[0].xf = w - Points[3].xf;
-                    Points[2].xf = 0;
-                    Points[1].xf = w;
-                }
-
-                Points[2].yf = h / 2 - scale * (h / 2 - Points[2].yf);
-                Points[3].yf = h - Points[2].yf;
-
-                Points[0].yf = Points[3].yf;
-                Points[1].yf = Points[2].yf;
-            }
-
-            if (Points[2].yf > Points[3].yf) {
-                effcommon_h_fillladder(src_dc, rc.left, rc.top, rc.right, rc.bottom,
-                        dst_dc, rc.left, rc.top, rc.right, rc.bottom,
-                        Points[0].xf, Points[0].yf,
-                        Points[1].xf, Points[1].yf,
-                        Points[2].xf, Points[2].yf,
-                        Points[3].xf, Points[3].yf);
-            }
-#endif
-        } else if (mv->y) {
-            Points3D[0].x = - w / 2;
-            Points3D[0].y = h;
-            Points3D[0].z = 0;
-
-            Points3D[1].x = (w + 1) / 2;
-            Points3D[1].y = h;
-            Points3D[1].z = 0;
-
-            Set3DPointOfView(pTransAffine, 0, 0, 0);
-            RotateHoriz3DSence(pTransAffine, dAngle);
-            for (i = 0; i < 2; ++i) {
-                Generate3DPointBy3DSence(pTransAffine, &Points3D[i]);
-                Perspective3DTo2D(&Points3D[i], &Points2D[i], nZprep, 0, 0);
-            }
-            Terminate3DSenceTransAffine (pTransAffine);
-
-            Points[3].xf = Points2D[0].x + w / 2;
-            Points[3].yf = Points2D[0].y;
-
-            Points[0].xf = Points[3].xf;
-            Points[0].yf = h - Points2D[0].y;
-
-            Points[2].xf = Points2D[1].x + w / 2;
-            Points[2].yf = Points2D[1].y;
-
-            Points[1].xf = Points[2].xf;
-            Points[1].yf = h - Points2D[1].y;
-
-            if (Points[3].yf != h && Points[2].yf != h) {
-                double scale;
-                if (Points[3].yf > h) {
-                    scale = (float)h / Points[3].yf;
-                    Points[3].yf = h;
-                    Points[0].yf = 0;
-                    Points[2].yf = h / 2 - scale * (h / 2 - Points[2].yf);
-                    Points[1].yf = h - Points[2].yf;
-
-                } else {
-                    scale = (float)h / Points[2].yf;
-                    Points[3].yf = h / 2 - scale * (h / 2 - Points[3].yf);
-                    Points[0].yf = h - Points[3].yf;
-                    Points[2].yf = h;
-                    Points[1].yf = 0;
-                }
-
-                Points[3].xf = w / 2 - scale * (w / 2 - Points[3].xf);
-                Points[2].xf = w - Points[3].xf;
+        assert(mv->x || mv->y);
 
-                Points[0].xf = Points[3].xf;
-                Points[1].xf = Points[2].xf;
-            }
-
-#ifdef DEBUG
-            printf ("%f %f\n", Points[1].xf, Points[1].yf);
-            printf ("%f %f\n", Points[2].xf, Points[2].yf);
-            printf ("%f %f\n", Points[3].xf, Points[3].yf);
-            printf ("%f %f\n", Points[0].xf, Points[0].yf);
-            printf ("\n");
-#endif
-
-            if (Points[1].xf > Points[0].xf) {
-                effcommon_v_fillladder(src_dc, rc.left, rc.top, rc.right, rc.bottom,
-                        dst_dc, rc.left, rc.top, rc.right, rc.bottom,
-                        Points[1].xf, Points[1].yf,
-                        Points[2].xf, Points[2].yf,
-                        Points[3].xf, Points[3].yf,
-                        Points[0].xf, Points[0].yf);
-            }
-#if 0
-        }
-        else if (mv->z)
-            Roll3DSence(pTransAffine, dAngle);
-#endif
-        }
-        else {
-            assert(0);
-        }
+        Warp_rotate(dst_dc, src_dc, mv->angle,
+                mv->x ? WARP_AXIS_X : WARP_AXIS_Y, flags);
     }
 }
 
@@ -301,15 +90,14 @@ static void set_transroundpiece_paintmode(mPieceItem *item, TRANROUND_PAINTMODE
 
         mPanelPiece *panel = (mPanelPiece*)piece;
         mPieceItem *itemChild = NULL;
-        mItemIterator *iter = _c(panel->itemManager)->createItemIterator(panel->itemManager);
+        ITEM_CURSOR cursor;
 
         if (_c(panel)->getBkgndPiece(panel)) {
             mHotPiece* bk = (mHotPiece*)_c(panel)->getBkgndPiece(panel);
             _c(bk)->setProperty(bk, NCSP_TRANROUND_PAINTMODE, mode);
         }
-        while ((itemChild = _c(iter)->next(iter)))
+        FOR_EACH_ITEM(panel->itemManager, cursor, itemChild)
             set_transroundpiece_paintmode(itemChild, mode);
-        DELETE(iter);
     } else if (INSTANCEOF(piece, mShapeTransRoundPiece)) {
 
         _c(piece)->setProperty(piece, NCSP_TRANROUND_PAINTMODE, mode);
@@ -325,66 +113,131 @@ static void paintmode_should_be_reset(mHotPiece* piece)
     topPanel->shouldResetPaintMode = TRUE;
 }
 
-static void test_rotate_and_paint(mPieceItem *item, HDC hdc, mObject *owner, DWORD add_data)
+static SURFACE_POOL* s_getSurfacePool(mPanelPiece *self)
+{
+    mPanelPiece *root = self;
+
+    while (root->parent && root->parent != (mHotPiece*)-1) {
+        root = (mPanelPiece*)root->parent;
+    }
+
+    if (root->surfacePool == NULL) {
+        root->surfacePool = SurfacePool_create(SURFACEPOOL_DEFAULT_BUDGET);
+    }
+    return root->surfacePool;
+}
+
+/* bring the retained layer of item up to date, HDC_INVALID if it can not
+ * be created */
+static HDC s_updateLayer(mPieceItem *item, HDC ref_dc, mObject *owner, DWORD add_data)
+{
+    RECT rc, dirty;
+    HDC layer;
+
+    _c(item->piece)->getRect(item->piece, &rc);
+    layer = LayerCache_acquire(item, ref_dc, RECTW(rc), RECTH(rc));
+    if (layer == HDC_INVALID)
+        return HDC_INVALID;
+
+    if (LayerCache_takeDirtyRect(item, &dirty)) {
+        OffsetRect(&rc, -rc.left, -rc.top);
+        IntersectRect(&dirty, &dirty, &rc);
+
+        SelectClipRect(layer, &dirty);
+        SetBrushColor(layer, RGBA2Pixel(layer, 0, 0, 0, 0));
+        FillBox(layer, dirty.left, dirty.top, RECTW(dirty), RECTH(dirty));
+
+        set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_GRAPHICSAVE);
+        paintmode_should_be_reset(item->piece);
+        /* a panel only repaints the children under the dirty part */
+        _c(item->piece)->setProperty(item->piece, NCSP_PANEL_CLIPRECT, (DWORD)&dirty);
+        PAINTTRACE_PAINT(item->piece, layer, owner, add_data);
+        SelectClipRect(layer, NULL);
+    }
+    return layer;
+}
+
+/* paint the piece of item at (0, 0) of hdc, from its layer if it has one */
+static void s_paintItem(mPieceItem *item, HDC hdc, mObject *owner, DWORD add_data)
+{
+    if (item->isEnableCache) {
+        HDC layer = s_updateLayer(item, hdc, owner, add_data);
+        if (layer != HDC_INVALID) {
+            double start = FrameStats_now();
+            BitBlt(layer, 0, 0, 0, 0, hdc, 0, 0, 0);
+            FrameStats_endComposite(start);
+            return;
+        }
+    }
+    PAINTTRACE_PAINT(item->piece, hdc, owner, add_data);
+}
+
+static void test_rotate_and_paint(mPieceItem *item, HDC hdc, mObject *owner, DWORD add_data,
+        SURFACE_POOL *pool)
 {
     if (item->normalVector.angle != 0.0 && item->normalVector.angle != 180.0) {
         /* need rotate */
-        //mPanelPiece* panel = (mPanelPiece*)item->piece;
+        mPanelPiece* panel = (mPanelPiece*)item->piece->parent;
+        DWORD flags = panel->rotateBilinear ? WARP_FLAG_BILINEAR : 0;
         RECT rc;
         HDC rotate_dc;
         HDC alpha_dc;
 
-        if (item->isEnableCache) {
-            getRectFromDC(hdc, &rc);
-
-            if (item->cacheDC == HDC_INVALID) {
-                //item->cacheDC = CreateCompatibleDCEx(hdc, RECTW(rc), RECTH(rc));
-                if ( 0 == GetGDCapability(hdc, GDCAP_AMASK) ) {
-                    item->cacheDC = CreateMemDC(RECTW(rc), RECTH(rc), 32, MEMDC_FLAG_HWSURFACE, 
-                            0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
-                }
-                else {
-                    item->cacheDC = CreateCompatibleDCEx(hdc, RECTW(rc), RECTH(rc));
-                }
-
-                set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_GRAPHICSAVE);
-                paintmode_should_be_reset(item->piece);
-                _c(item->piece)->paint(item->piece, item->cacheDC, owner, add_data); 
-            }
-
+        if (item->isEnableCache
+                && s_updateLayer(item, hdc, owner, add_data) != HDC_INVALID) {
+            double start = FrameStats_now();
+            alpha_dc = HDC_INVALID;
             if ( 0 == GetGDCapability(hdc, GDCAP_AMASK) ) {
-                alpha_dc = CreateCompatibleDC(item->cacheDC);
+                RECT cacheRc;
+                getRectFromDC(item->cacheDC, &cacheRc);
+                alpha_dc = SurfacePool_get(pool, item->cacheDC, RECTW(cacheRc), RECTH(cacheRc));
+            }
+            if (alpha_dc != HDC_INVALID) {
                 BitBlt(hdc, 0, 0, 0, 0, alpha_dc, 0, 0, 0);
-                rotate(alpha_dc, item->cacheDC, &item->normalVector);
+                rotate(alpha_dc, item->cacheDC, &item->normalVector, flags);
                 BitBlt(alpha_dc, 0, 0, 0, 0, hdc, 0, 0, 0);
-                DeleteMemDC(alpha_dc);
+                SurfacePool_put(pool, alpha_dc);
             }
             else{
-                rotate(hdc, item->cacheDC, &item->normalVector);
+                /* an alpha hdc, or the pool is out of budget or memory */
+                rotate(hdc, item->cacheDC, &item->normalVector, flags);
             }
+            FrameStats_endComposite(start);
 
             //rotate(hdc, item->cacheDC, &item->normalVector);
         }
         else {
+            double start;
+
             getRectFromDC(hdc, &rc);
-            rotate_dc = CreateCompatibleDCEx(hdc, RECTW(rc), RECTH(rc));
+            rotate_dc = SurfacePool_get(pool, hdc, RECTW(rc), RECTH(rc));
+            if (rotate_dc == HDC_INVALID)
+                return;
+
+            /* a recycled surface keeps the pixels of its last user */
+            SetBrushColor(rotate_dc, RGBA2Pixel(rotate_dc, 0, 0, 0, 0));
+            FillBox(rotate_dc, 0, 0, RECTW(rc), RECTH(rc));
             
             set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_GRAPHICSAVE);
             
             paintmode_should_be_reset(item->piece);
             
-            _c(item->piece)->paint(item->piece, rotate_dc, owner, add_data);
+            PAINTTRACE_PAINT(item->piece, rotate_dc, owner, add_data);
             
-            rotate(hdc, rotate_dc, &item->normalVector);
+            start = FrameStats_now();
+            rotate(hdc, rotate_dc, &item->normalVector, flags);
+            FrameStats_endComposite(start);
             
-            DeleteMemDC(rotate_dc);
+            SurfacePool_put(pool, rotate_dc);
         }
     } else {
         /* no need rotate */
-        _c(item->piece)->paint(item->piece, hdc, owner, add_data);
+        s_paintItem(item, hdc, owner, add_data);
     }
 }
 
+/* subclasses wanting indexed access to their items return an
+ * mArrayItemManager instead */
 static mAbstractItemManager *mPanelPiece_createItemManager(mPanelPiece *self)
 {
     return (mAbstractItemManager*)NEW(mListItemManager);
@@ -400,11 +253,17 @@ static mPieceItem *mPanelPiece_createItemNode(mPanelPiece *self, mHotPiece *piec
 {
     mPieceItem *item = NULL;
 
-    if ((item = NEW(mPieceItem)) == NULL)
+    if ((item = POOL_NEW(mPieceItem)) == NULL)
         assert(0);
 
     if (INSTANCEOF(piece, mPanelPiece)) {
-        ((mPanelPiece*)piece)->isTopPanel = FALSE;
+        mPanelPiece *panel = (mPanelPiece*)piece;
+        panel->isTopPanel = FALSE;
+        /* a nested panel borrows the surfaces of its top panel. */
+        if (panel->surfacePool) {
+            SurfacePool_destroy(panel->surfacePool);
+            panel->surfacePool = NULL;
+        }
     }
 
     item->x = x;
@@ -421,6 +280,8 @@ static mPieceItem *mPanelPiece_createItemNode(mPanelPiece *self, mHotPiece *piec
     _c(self)->initItemNode(self, item, piece);
 
     _c(self->itemManager)->addItem(self->itemManager, item);
+    PtrMap_put(self->itemMap, piece, item);
+    SpatialIndex_invalidate(self->spatialIndex);
 
     return item;
 }
@@ -437,70 +298,78 @@ static mPieceItem* mPanelPiece_addContentToLayout(mPanelPiece *self, mHotPiece *
 
     item->underLayout = TRUE;
 
+    /* laid out once per batch, see PanelPiece_flushLayout */
     if (self->layout) {
-        _c(self)->reLayout(self);
+        _c(self->layout)->invalidate(self->layout, LAYOUT_INDEX_END);
+        self->layoutDirty = TRUE;
     }
     return item;
 }
 
 static void mPanelPiece_addContentFinished(mPanelPiece *self)
-{}
+{
+    PanelPiece_flushLayout(self);
+}
 
 static BOOL mPanelPiece_delContent(mPanelPiece* self, mHotPiece* piece)
 {
-    mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
-    mPieceItem *item;
-    while ((item = _c(iter)->next(iter))) {
-        if (item->piece == piece) {
-            if (self->hovering_piece == piece) {
-                mWidget_releaseHoveringFocus();
-                self->hovering_piece = NULL;
+    mPieceItem *item = _c(self)->searchItem(self, piece);
+
+    if (item) {
+        if (self->hovering_piece == piece) {
+            mWidget_releaseHoveringFocus();
+            self->hovering_piece = NULL;
+        }
+        piece->parent = (mHotPiece*)-1;
+        if (item->underLayout && self->layout) {
+            /* only the array item manager knows the position of an item,
+             * item->index is its slot there, holes included */
+            int index = 0;
+            if (INSTANCEOF(self->itemManager, mArrayItemManager)) {
+                mArrayItemManager *manager = (mArrayItemManager*)self->itemManager;
+                index = _c(manager)->indexOf(manager, item);
             }
-            piece->parent = (mHotPiece*)-1;
-            UNREFPIECE(item->piece);
-            _c(self->itemManager)->removeItem(self->itemManager, item);
-            DELETE(item);
-            DELETE(iter);
-            return TRUE;
+            _c(self->layout)->invalidate(self->layout, index);
+            self->layoutDirty = TRUE;
         }
+        UNREFPIECE(item->piece);
+        _c(self->itemManager)->removeItem(self->itemManager, item);
+        PtrMap_remove(self->itemMap, piece);
+        SpatialIndex_invalidate(self->spatialIndex);
+        POOL_DELETE(item);
+        return TRUE;
     }
-    DELETE(iter);
 
-    /* houhh add delContent reLayout. */
-    if (self->layout) {
-        _c(self)->reLayout(self);
-    }
     return FALSE;
 }
 
 static void mPanelPiece_clearContents(mPanelPiece* self)
 {
-    mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
+    ITEM_CURSOR cursor;
     mPieceItem *item;
 
     mWidget_releaseHoveringFocus();
     self->hovering_piece = NULL;
-#if 0
-    while ((item = _c(iter)->next(iter))) {
-        DELPIECE(item->piece);
-        _c(self->itemManager)->removeItem(self->itemManager, item);
-        DELETE(item);
-    }
-#else
-    item = _c(iter)->next(iter);
-    while (item) {
-        mPieceItem* prev = item;
+    PtrMap_clear(self->itemMap);
+    SpatialIndex_invalidate(self->spatialIndex);
+    /* the cursor has fetched the next item before the current one goes */
+    FOR_EACH_ITEM(self->itemManager, cursor, item) {
         UNREFPIECE(item->piece);
         _c(self->itemManager)->removeItem(self->itemManager, item);
-        item = _c(iter)->next(iter);
-        DELETE(prev);
+        POOL_DELETE(item);
+    }
+
+    /* the layout still caches the rows of the old content */
+    if (self->layout) {
+        _c(self->layout)->invalidate(self->layout, 0);
+        self->layoutDirty = TRUE;
     }
-#endif
-    DELETE(iter);
 }
 
-static void mPanelPiece_reLayout(mPanelPiece *self)
+static void s_doLayout(mPanelPiece *self)
 {
+    self->layoutDirty = FALSE;
+    SpatialIndex_invalidate(self->spatialIndex);
     if (self->layout) {
         RECT rc;
         mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
@@ -510,6 +379,15 @@ static void mPanelPiece_reLayout(mPanelPiece *self)
     }
 }
 
+static void mPanelPiece_reLayout(mPanelPiece *self)
+{
+    /* the caller may have changed any item, lay them all out */
+    if (self->layout) {
+        _c(self->layout)->invalidate(self->layout, 0);
+    }
+    s_doLayout(self);
+}
+
 static void mPanelPiece_setLayoutManager(mPanelPiece *self, mLayoutManager *layout)
 {
     if (self->layout) {
@@ -527,8 +405,17 @@ static BOOL mPanelPiece_setRect(mPanelPiece *self, const RECT *prc)
 {
     BOOL ret = Class(mStaticPiece).setRect((mStaticPiece*)self, prc);
 
-    if (ret)
+    if (ret) {
+        /* nothing painted yet at this size, a direct paint covers it all */
+        _c(self)->getRect(self, &self->clipRect);
+        /* the grid has to cover the new size */
+        SpatialIndex_invalidate(self->spatialIndex);
+        /* and the grid of the parent has us at the old size */
+        if (self->parent && self->parent != (mHotPiece*)-1
+                && INSTANCEOF(self->parent, mPanelPiece))
+            SpatialIndex_invalidate(((mPanelPiece*)self->parent)->spatialIndex);
         _c(self)->reLayout(self);
+    }
      
     return ret;
 }
@@ -544,30 +431,23 @@ static void mPanelPiece_enableChildCache(mPanelPiece *self, mHotPiece* child, BO
     _DBG_PRINTF ("%s:%d enable panel child:%p, cache: %d.\n", __FUNCTION__, __LINE__, child, enable);
 
     item->isEnableCache = enable;
+    if (!enable)
+        LayerCache_release(item);
 }
 
 static BOOL mPanelPiece_updateChildCache(mPanelPiece *self, mHotPiece* child)
 {
-    RECT clipRect;
     mPieceItem *item = NULL;
-    mPanelPiece* itempiece = NULL;
     item = _c(self)->searchItem(self, child);
 
-    if (item == NULL || item->isEnableCache == FALSE || item->cacheDC == HDC_INVALID) 
+    if (item == NULL || item->isEnableCache == FALSE) 
         return FALSE;
-    else
-        itempiece = (mPanelPiece*)item->piece;
 
     _DBG_PRINTF ("%s:%d update panel child:%p, cache: %p.\n", __FUNCTION__, __LINE__, child, item->cacheDC);
 
-    set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_GRAPHICSAVE);
-    paintmode_should_be_reset(item->piece);
-
-    /* set the panelpiece cliprect to whole piece rect for it can be update to cacheDC */
-    clipRect = itempiece->clipRect;
-    _c(itempiece)->getRect(itempiece, &itempiece->clipRect);
-    _c(item->piece)->paint(item->piece, item->cacheDC, (mObject*)self->owner, 0); 
-    itempiece->clipRect = clipRect;
+    /* the layer is repainted the next time the child is composited */
+    LayerCache_markDirty(item, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 
     return TRUE;
 }
@@ -578,6 +458,21 @@ static BOOL mPanelPiece_setProperty(mPanelPiece* self, intptr_t id, DWORD value)
         case NCSP_PANEL_CLIPRECT:
             self->clipRect = *((RECT*)value);
             break;
+        case NCSP_PANEL_SURFACEPOOL_BUDGET:
+            SurfacePool_setBudget(s_getSurfacePool(self), (size_t)value);
+            break;
+        case NCSP_PANEL_SPATIALINDEX:
+            SpatialIndex_destroy(self->spatialIndex);
+            self->spatialIndex = NULL;
+            if ((int)value > 0)
+                self->spatialIndex = SpatialIndex_create((int)value);
+            break;
+        case NCSP_PANEL_SCALE_MIPMAP:
+            self->scaleMipmap = (BOOL)value;
+            break;
+        case NCSP_PANEL_ROTATE_BILINEAR:
+            self->rotateBilinear = (BOOL)value;
+            break;
         default:
             return Class(mStaticPiece).setProperty((mStaticPiece*)self, id, value);
     }
@@ -588,39 +483,259 @@ static void mPanelPiece_setClipRect(mPanelPiece* self, const mPieceItem* item)
 {
     RECT rc = self->clipRect;
     mHotPiece* piece = item->piece;
-    OffsetRect(&rc, -item->x, -item->y);
+
+    if (item->wscalefactor != 1.0 || item->hscalefactor != 1.0
+            || item->isEnableCache
+            || (item->normalVector.angle != 0.0 && item->normalVector.angle != 180.0)) {
+        /* the damage can not be mapped into a scaled, rotated or cached
+         * child, let it paint everything */
+        _c(piece)->getRect(piece, &rc);
+    }
+    else {
+        OffsetRect(&rc, -item->x, -item->y);
+    }
     _c(piece)->setProperty(piece, NCSP_PANEL_CLIPRECT, (DWORD)&rc);
 }
 
+/* scale the alpha channel of the ARGB pixels of rc in dc by alpha / 255 */
+static void s_modulateAlpha(HDC dc, const RECT *rc, int alpha)
+{
+    int w, h, pitch, x, y;
+    Uint8 *bits;
+
+    bits = LockDC(dc, rc, &w, &h, &pitch);
+    if (bits == NULL)
+        return;
+
+    for (y = 0; y < h; y++) {
+        Uint32 *pixel = (Uint32*)(bits + y * pitch);
+        for (x = 0; x < w; x++) {
+            Uint32 a = (pixel[x] >> 24) * alpha + 128;
+            /* a / 255, rounded */
+            a = (a + (a >> 8)) >> 8;
+            pixel[x] = (pixel[x] & 0x00FFFFFF) | (a << 24);
+        }
+    }
+    UnlockDC(dc);
+}
+
+/*
+ * Composite a translucent, unscaled child: paint it once into a clear ARGB
+ * scratch surface, fold the item alpha into the alpha channel and let a
+ * single per-pixel alpha blit blend it over hdc. Only the visible part of
+ * the child is touched.
+ */
+static void s_paintTranslucentItem(mPanelPiece *self, mPieceItem *item, HDC hdc,
+        int left, int top, mObject *owner, SURFACE_POOL *pool)
+{
+    RECT rc, vis;
+    HDC scratch;
+    double start;
+
+    if (item->alpha <= 0)
+        return;
+
+    _c(item->piece)->getRect(item->piece, &rc);
+    vis = item->visibleRect;
+    OffsetRect(&vis, -item->x, -item->y);
+    if (!IntersectRect(&vis, &vis, &rc))
+        return;
+
+    scratch = SurfacePool_getARGB(pool, RECTW(rc), RECTH(rc));
+    if (scratch == HDC_INVALID)
+        return;
+
+    /* a recycled surface keeps the pixels of its last user */
+    SelectClipRect(scratch, &vis);
+    SetBrushColor(scratch, RGBA2Pixel(scratch, 0, 0, 0, 0));
+    FillBox(scratch, vis.left, vis.top, RECTW(vis), RECTH(vis));
+
+    set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_GRAPHICSAVE);
+    paintmode_should_be_reset(item->piece);
+    test_rotate_and_paint(item, scratch, owner, 0, pool);
+
+    start = FrameStats_now();
+    s_modulateAlpha(scratch, &vis, item->alpha);
+    SetMemDCAlpha(scratch, MEMDC_FLAG_SRCPIXELALPHA, 0);
+    BitBlt(scratch, vis.left, vis.top, RECTW(vis), RECTH(vis),
+            hdc, left + vis.left, top + vis.top, 0);
+    FrameStats_endComposite(start);
+
+    SurfacePool_put(pool, scratch);
+}
+
+/*
+ * Composite a scaled, unrotated child from its retained layer, which is
+ * only repainted where the child changed; an animated zoom then costs one
+ * resample per frame. Scaled down by half or more, the closest
+ * downscaled level of the layer is used instead.
+ */
+static BOOL s_paintScaledItem(mPanelPiece *self, mPieceItem *item, HDC hdc,
+        int left, int top, int w, int h, mObject *owner, DWORD add_data)
+{
+    HDC layer;
+    int level = 0;
+    double start;
+
+    if (item->normalVector.angle != 0.0 && item->normalVector.angle != 180.0)
+        return FALSE;
+
+    /* a fading zoom goes through the translucent path below */
+    if (item->alpha != 255)
+        return FALSE;
+
+    layer = s_updateLayer(item, hdc, owner, add_data);
+    if (layer == HDC_INVALID)
+        return FALSE;
+
+    if (self->scaleMipmap) {
+        float scale = MAX(item->wscalefactor, item->hscalefactor);
+
+        while (level < LAYERCACHE_MAX_LEVEL && scale <= 0.5) {
+            scale *= 2;
+            level++;
+        }
+        layer = LayerCache_getLevel(item, level);
+    }
+
+    start = FrameStats_now();
+    StretchBlt(layer, 0, 0, 0, 0, hdc, left, top, w, h, 0);
+    FrameStats_endComposite(start);
+    return TRUE;
+}
+
+/* the part of piece known to be painted with opaque pixels */
+static BOOL s_getPieceOpaqueRect(mHotPiece *piece, RECT *prc)
+{
+    if (INSTANCEOF(piece, mPanelPiece)) {
+        return _c((mPanelPiece*)piece)->getOpaqueRect((mPanelPiece*)piece, prc);
+    } else if (INSTANCEOF(piece, mShapeTransRoundPiece)) {
+        mShapeTransRoundPiece *shape = (mShapeTransRoundPiece*)piece;
+        return _c(shape)->getOpaqueRect(shape, prc);
+    }
+    return FALSE;
+}
+
+/* the bound of what item paints, in the coordinates of the panel */
+static void s_getItemPaintRect(mPieceItem *item, RECT *prc)
+{
+    int w, h;
+
+    s_getItemRect(item, prc);
+    if (item->wscalefactor != 1.0 || item->hscalefactor != 1.0) {
+        w = RECTWP(prc) * item->wscalefactor;
+        h = RECTHP(prc) * item->hscalefactor;
+        prc->left += (RECTWP(prc) - w) / 2;
+        prc->top  += (RECTHP(prc) - h) / 2;
+        prc->right = prc->left + w;
+        prc->bottom = prc->top + h;
+    }
+}
+
+static BOOL s_getItemOpaqueRect(mPieceItem *item, RECT *prc)
+{
+    if (item->alpha != 255 || item->wscalefactor != 1.0
+            || item->hscalefactor != 1.0 || item->normalVector.angle != 0.0)
+        return FALSE;
+
+    if (!s_getPieceOpaqueRect(item->piece, prc))
+        return FALSE;
+    OffsetRect(prc, item->x, item->y);
+    return TRUE;
+}
+
+/*
+ * Front to back pre-pass of paint: set the visibleRect of every child to
+ * the bound of its part inside clipRect that no opaque child in front of
+ * it covers, empty if it is hidden. Returns FALSE if the children cover
+ * all of clipRect, so that the background is hidden too.
+ */
+static BOOL s_cullOccludedItems(mPanelPiece *self, const RECT *clipRect)
+{
+    ITEM_CURSOR cursor;
+    mPieceItem *item;
+    PCLIPRGN visible = NULL;
+    PCLIPRGN part = NULL;
+    BOOL uncovered = TRUE;
+
+    FOR_EACH_ITEM_REVERSE(self->itemManager, cursor, item) {
+        RECT rc, opaque;
+
+        s_getItemPaintRect(item, &rc);
+        if (!IntersectRect(&item->visibleRect, &rc, clipRect)) {
+            SetRectEmpty(&item->visibleRect);
+            continue;
+        }
+
+        /* nothing opaque in front of it so far */
+        if (visible != NULL) {
+            CopyRegion(part, visible);
+            IntersectClipRect(part, &item->visibleRect);
+            if (IsEmptyClipRgn(part)) {
+                SetRectEmpty(&item->visibleRect);
+                continue;
+            }
+            item->visibleRect = part->rcBound;
+        }
+
+        if (s_getItemOpaqueRect(item, &opaque)) {
+            if (visible == NULL) {
+                visible = CreateClipRgn();
+                part = CreateClipRgn();
+                SetClipRgn(visible, clipRect);
+            }
+            SubtractClipRect(visible, &opaque);
+        }
+    }
+
+    if (visible != NULL) {
+        uncovered = !IsEmptyClipRgn(visible);
+        DestroyClipRgn(visible);
+        DestroyClipRgn(part);
+    }
+    return uncovered;
+}
+
 static void mPanelPiece_paint(mPanelPiece* self, HDC hdc, mObject* owner, DWORD add_data)
 {
     RECT containerRc, clipRect;
     HDC tmpdc = HDC_INVALID;
-    mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
+    ITEM_CURSOR cursor;
     mPieceItem *item = NULL;
+    SURFACE_POOL *pool = s_getSurfacePool(self);
 
+    PanelPiece_flushLayout(self);
     _c(self)->getRect(self, &containerRc);
     clipRect = containerRc;
-    if (RECTW(self->invalidRect) 
-            && RECTH(self->invalidRect)) {
-        IntersectRect(&clipRect, &clipRect, &self->invalidRect);
-        _DBG_PRINTF ("piece is %p, clipRect is (%d,%d,%d,%d).\n",
-                self, clipRect.left, clipRect.top, clipRect.right, clipRect.bottom);
+    if (self->isTopPanel) {
+        /* damage handed over by the container */
+        if (RECTW(self->invalidRect) 
+                && RECTH(self->invalidRect)) {
+            IntersectRect(&clipRect, &clipRect, &self->invalidRect);
+        }
+    }
+    else {
+        /* damage forwarded by the parent panel through setClipRect */
+        IntersectRect(&clipRect, &clipRect, &self->clipRect);
+    }
+    _DBG_PRINTF ("piece is %p, clipRect is (%d,%d,%d,%d).\n",
+            self, clipRect.left, clipRect.top, clipRect.right, clipRect.bottom);
+
+    self->clipRect = clipRect;
+    if (IsRectEmpty(&clipRect)) {
+        self->clipRect = containerRc;
+        return;
     }
 
     /* set clip rect of hdc */
     ClipRectIntersect(hdc, &clipRect);
 
-    /* draw background.*/
-    if (self->bkgndPiece) {
-        _c(self->bkgndPiece)->paint(self->bkgndPiece, hdc, owner, add_data);
-    }
-
-    if (self->isTopPanel) {
-        self->clipRect = clipRect;
+    /* draw background, unless opaque children hide it.*/
+    if (s_cullOccludedItems(self, &clipRect) && self->bkgndPiece) {
+        PAINTTRACE_PAINT(self->bkgndPiece, hdc, owner, add_data);
     }
 
-    while ((item = _c(iter)->next(iter))) {
+    FOR_EACH_ITEM(self->itemManager, cursor, item) {
         RECT rc;
         RECT rc2;
         int centerx, centery, left, top, w, h;
@@ -641,18 +756,37 @@ static void mPanelPiece_paint(mPanelPiece* self, HDC hdc, mObject* owner, DWORD
         if (left >= containerRc.right || top >= containerRc.bottom)
             continue;
 
+        /* hidden by the opaque children in front of it */
+        if (IsRectEmpty(&item->visibleRect))
+            continue;
+
         rc2.left = item->x;
         rc2.top  = item->y;
         rc2.right  = rc2.left + RECTW(rc);
         rc2.bottom = rc2.top  + RECTH(rc);
+        if (!DoesIntersect(&clipRect, &rc2)){
+            continue;
+        }
+        /* only forward the visible part of the damage to the child, which
+         * drops it again at the end of its paint */
+        self->clipRect = item->visibleRect;
         _c(self)->setClipRect(self, item);
-        if (!DoesIntersect(&self->clipRect, &rc2)){
+        self->clipRect = clipRect;
+
+        if (item->wscalefactor == 1.0 && item->hscalefactor == 1.0) {
+            if (item->alpha != 255) {
+                s_paintTranslucentItem(self, item, hdc, left, top, owner, pool);
+                continue;
+            }
+        } else if (s_paintScaledItem(self, item, hdc, left, top, w, h, owner, add_data)) {
             continue;
         }
 
         if (self->isTopPanel || item->alpha != 255) {
-            /* create memdc */
-            tmpdc = CreateCompatibleDCEx(hdc, RECTW(rc), RECTH(rc));
+            /* get a recycled memdc */
+            tmpdc = SurfacePool_get(pool, hdc, RECTW(rc), RECTH(rc));
+            if (tmpdc == HDC_INVALID)
+                continue;
         } else {
             /* get sub memdc */
             tmpdc = GetSubDC(hdc, left, top, RECTW(rc), RECTH(rc));
@@ -673,16 +807,21 @@ static void mPanelPiece_paint(mPanelPiece* self, HDC hdc, mObject* owner, DWORD
             int xt = (left >= 0) ? 0 : -left;
             int yt = (top >= 0) ? 0 : -top;
             if ((w - xt > 0) && (h - yt > 0)) {
+                double start = FrameStats_now();
                 StretchBlt(hdc, left + xt, top + yt, w - xt, h - yt,
                         tmpdc, xt, yt, 0, 0, 0);
+                FrameStats_endComposite(start);
                 test_rotate_and_paint(item, tmpdc, owner,
-                        (DWORD)1);
+                        (DWORD)1, pool);
+                start = FrameStats_now();
                 StretchBlt(tmpdc, xt, yt, 0, 0,
                         hdc, left + xt, top + yt, w - xt, h - yt, 0);
+                FrameStats_endComposite(start);
             }
         } else {
             /* no need scale */
             if (self->isTopPanel || item->alpha != 255) {
+                double start;
                 // should *RESET* all paintmode of shapeTransRoundPiece to 
                 // TRANROUND_PAINTMODE_BITBLT
                 // if self is the top panel piece
@@ -690,28 +829,29 @@ static void mPanelPiece_paint(mPanelPiece* self, HDC hdc, mObject* owner, DWORD
                     set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_BITBLT);
                     self->shouldResetPaintMode = FALSE;
                 }
-                /* set alpha */
+                start = FrameStats_now();
                 BitBlt(hdc, left, top, w, h, tmpdc, 0, 0, 0);
-                if (item->alpha != 255) {
-                    set_transroundpiece_paintmode(item, TRANROUND_PAINTMODE_GRAPHICSAVE);
-                    SetMemDCAlpha(tmpdc, MEMDC_FLAG_SRCALPHA, item->alpha);
-                }
-                test_rotate_and_paint(item, tmpdc, owner, 0);
+                FrameStats_endComposite(start);
+                test_rotate_and_paint(item, tmpdc, owner, 0, pool);
+                start = FrameStats_now();
                 BitBlt(tmpdc, 0, 0, 0, 0, hdc, left, top, 0);
+                FrameStats_endComposite(start);
             } else {
-                test_rotate_and_paint(item, tmpdc, owner, add_data);
+                test_rotate_and_paint(item, tmpdc, owner, add_data, pool);
             }
         }
 
         //if (self->isTopPanel) {
         if (self->isTopPanel || item->alpha != 255) {
-            DeleteMemDC(tmpdc);
+            SurfacePool_put(pool, tmpdc);
         } else {
             ReleaseDC(tmpdc);
         }
     }
 
-    DELETE(iter);
+    /* the damage forwarded by the parent only holds for this paint, a
+     * later direct paint that skips setClipRect has to cover everything */
+    self->clipRect = containerRc;
 }
 
 static void mPanelPiece_construct(mPanelPiece* self, DWORD add_data)
@@ -722,29 +862,42 @@ static void mPanelPiece_construct(mPanelPiece* self, DWORD add_data)
     self->shouldResetPaintMode = FALSE;
     self->hovering_piece = NULL;
     self->layout = NULL;
+    self->layoutDirty = FALSE;
 
     self->itemManager = _c(self)->createItemManager(self);
+    self->itemMap = PtrMap_create();
 
-    INIT_LIST_HEAD(&self->eventHandlers);
+    self->eventHandlers = NULL;
+    self->nr_eventHandlers = 0;
+    self->max_eventHandlers = 0;
+    self->eventMask = 0;
 
     self->owner = NULL;
     self->update_flag = FALSE;
+    self->update_anim = NULL;
+    self->clockDeadline = 0;
+    self->clockIdleTicks = 0;
     self->parent = NULL;
 
     self->addData = add_data;
     memset(&self->invalidRect, 0, sizeof(RECT));
+    self->surfacePool = NULL;
+    self->nr_damage_rects = 0;
+    self->spatialIndex = NULL;
+    self->scaleMipmap = TRUE;
+    self->rotateBilinear = FALSE;
 
     /* add */
 }
 
 static void mPanelPiece_destroy(mPanelPiece* self)
 {
-    /* TODO: event handlers */
-
     // stop update animation if exists
     if (self->update_anim) {
+        mGEffAnimationSetFinishedCb(self->update_anim, NULL);
         mGEffAnimationStop(self->update_anim);
         self->update_anim = NULL;
+        FrameStats_clockStopped();
     }
 
     if (self->layout) DELETE(self->layout);
@@ -752,10 +905,20 @@ static void mPanelPiece_destroy(mPanelPiece* self)
     _c(self)->clearContents(self);
     _c(self)->clearEventHandler(self);
     DELETE(self->itemManager);
+    PtrMap_destroy(self->itemMap);
+    self->itemMap = NULL;
 
     if (self->bkgndPiece)
         UNREFPIECE(self->bkgndPiece);
 
+    if (self->surfacePool) {
+        SurfacePool_destroy(self->surfacePool);
+        self->surfacePool = NULL;
+    }
+
+    SpatialIndex_destroy(self->spatialIndex);
+    self->spatialIndex = NULL;
+
     Class(mStaticPiece).destroy((mStaticPiece*)self);
 }
 
@@ -766,66 +929,21 @@ static mHotPiece *mPanelPiece_hitTest(mPanelPiece* self, int x, int y)
 
 static mPieceItem *mPanelPiece_searchItem(mPanelPiece *self, mHotPiece *child)
 {
-    mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
-    mPieceItem *item = NULL;
-    while ((item = _c(iter)->next(iter))) {
-        if (item->piece && item->piece == child)
-            break;
-    }
-    DELETE(iter);
-    return item;
-}
-
-enum {
-    ANIM_MOVE = 1,
-    ANIM_SCALE,
-    ANIM_ROTATE,
-    ANIM_ALPHA,
-};
-
-static void _piece_anim_cb(MGEFF_ANIMATION handle, void *target, intptr_t id, void *value)
-{
-    mHotPiece* child = (mHotPiece*)target;
-    mPanelPiece* self = (mPanelPiece*) child->parent;
-    assert(self);
-    assert(child);
+    ITEM_CURSOR cursor;
+    mPieceItem *item;
 
-    switch (id) {
-        case ANIM_MOVE:
-            {
-                POINT* pt = (POINT*)value;
+    if ((item = (mPieceItem*)PtrMap_get(self->itemMap, child)))
+        return item;
 
-                _c(self)->movePiece(self, child, pt->x, pt->y);
-            }
-            break;
-        case ANIM_SCALE:
-            {
-                POINTF *ptf = (POINTF*)value;
-                float wscalefactor = (ptf->xf < 0.0) ? 0.0 : ptf->xf;
-                float hscalefactor = (ptf->yf < 0.0) ? 0.0 : ptf->yf;
-                _c(self)->scalePiece(self, child, wscalefactor, hscalefactor);
-            }
-            break;
-        case ANIM_ROTATE:
-            {
-                float angle = (*(float*)value >= ROTATE_90 * 2) ? 0.0 : *(float*)value;
-                mPieceItem *item =  (item = _c(self)->searchItem(self, child));
-                assert(item);
-                _c(self)->rotatePiece(self, child, angle, 
-                        item->normalVector.x, item->normalVector.y, item->normalVector.z);
-            }
-            break;
-        case ANIM_ALPHA:
-            {
-                int alpha = *(int*)value;
-                _c(self)->setPieceAlpha(self, child, alpha);
-            }
-            break;
-        default:
-            assert(0);
+    /* not added by createItemNode, search it and remember the result */
+    FOR_EACH_ITEM(self->itemManager, cursor, item) {
+        if (item->piece && item->piece == child)
             break;
     }
 
+    if (item && self->itemMap)
+        PtrMap_put(self->itemMap, child, item);
+    return item;
 }
 
 /****************************MOVE PIECE START**********************************/
@@ -833,15 +951,25 @@ static void mPanelPiece_movePiece(mPanelPiece *self, mHotPiece *child, int x, in
 {
     mPieceItem *item = NULL;
 
+    /* a pending animated value must not land after this one */
+    PieceAnim_flush();
+
     if ((item = _c(self)->searchItem(self, child))) {
-        /* update old position */
-        _c(self)->invalidatePiece(self, child, NULL, FALSE);
+        RECT old_rc, new_rc;
 
+        /* update old position, moving does not change the child layer */
+        _c(self)->invalidatePiece(self, child, NULL, TRUE);
+
+        s_getItemRect(item, &old_rc);
         item->x = x;
         item->y = y;
+        if (SpatialIndex_isValid(self->spatialIndex)) {
+            s_getItemRect(item, &new_rc);
+            SpatialIndex_move(self->spatialIndex, item, &old_rc, &new_rc);
+        }
 
         /* update new position */
-        _c(self)->invalidatePiece(self, child, NULL, FALSE);
+        _c(self)->invalidatePiece(self, child, NULL, TRUE);
     }else{
         assert(0);
     }
@@ -853,15 +981,13 @@ static MGEFF_ANIMATION mPanelPiece_movePieceWithAnimation(mPanelPiece *self, mHo
     MGEFF_ANIMATION anim = NULL;
     mPieceItem *item = NULL;
     if ((item = _c(self)->searchItem(self, child))) {
-        POINT pt_s = { item->x, item->y };
-        POINT pt_e = { x, y };
-        anim = mGEffAnimationCreate(child, _piece_anim_cb, ANIM_MOVE, MGEFF_POINT);
-        assert(anim);
+        float from[2] = { item->x, item->y };
+        float to[2] = { x, y };
 
-        mGEffAnimationSetStartValue(anim, &pt_s);
-        mGEffAnimationSetEndValue(anim, &pt_e);
-        mGEffAnimationSetDuration(anim, duration);
-        mGEffAnimationSetCurve(anim, curve);
+        PieceAnim_flush();
+        anim = PieceAnim_create((mHotPiece*)self, item, PIECEANIM_MOVE,
+                from, to, duration, curve);
+        assert(anim);
         return anim;
     }
     return NULL;
@@ -873,16 +999,23 @@ static void mPanelPiece_scalePiece(mPanelPiece *self, mHotPiece *child, float ws
 {
     mPieceItem *item = NULL;
 
+    PieceAnim_flush();
+
     // update old position
-    PanelPiece_invalidatePiece((mHotPiece*)child, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 
     if ((item = _c(self)->searchItem(self, child))) {
         item->wscalefactor = (wscalefactor < 0.0) ? 0.0 : wscalefactor;
         item->hscalefactor = (hscalefactor < 0.0) ? 0.0 : hscalefactor;
+        /* back to its size, the layer kept for scaling is not needed */
+        if (item->wscalefactor == 1.0 && item->hscalefactor == 1.0
+                && !item->isEnableCache) {
+            LayerCache_release(item);
+        }
     }
 
     // update new position
-    PanelPiece_invalidatePiece((mHotPiece*)child, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 }
 
 static MGEFF_ANIMATION mPanelPiece_scalePieceWithAnimation(mPanelPiece *self, mHotPiece *child,
@@ -891,20 +1024,17 @@ static MGEFF_ANIMATION mPanelPiece_scalePieceWithAnimation(mPanelPiece *self, mH
     MGEFF_ANIMATION anim = NULL;
     mPieceItem *item = NULL;
     if ((item = _c(self)->searchItem(self, child))) {
-        POINTF ptf_s;
-        POINTF ptf_e;
-        anim = mGEffAnimationCreate(child, _piece_anim_cb, ANIM_SCALE, MGEFF_POINTF);
-        assert(anim);
+        float from[2], to[2];
 
-        ptf_s.xf = item->wscalefactor;
-        ptf_s.yf = item->hscalefactor;
-        ptf_e.xf = (wscalefactor < 0.0) ? 0.0 : wscalefactor;
-        ptf_e.yf = (hscalefactor < 0.0) ? 0.0 : hscalefactor;
+        PieceAnim_flush();
+        from[0] = item->wscalefactor;
+        from[1] = item->hscalefactor;
+        to[0] = (wscalefactor < 0.0) ? 0.0 : wscalefactor;
+        to[1] = (hscalefactor < 0.0) ? 0.0 : hscalefactor;
 
-        mGEffAnimationSetStartValue(anim, &ptf_s);
-        mGEffAnimationSetEndValue(anim, &ptf_e);
-        mGEffAnimationSetDuration(anim, duration);
-        mGEffAnimationSetCurve(anim, curve);
+        anim = PieceAnim_create((mHotPiece*)self, item, PIECEANIM_SCALE,
+                from, to, duration, curve);
+        assert(anim);
         return anim;
     }
     return NULL;
@@ -917,8 +1047,10 @@ static void mPanelPiece_rotatePiece(mPanelPiece *self, mHotPiece *child, float a
 {
     mPieceItem *item = NULL;
 
+    PieceAnim_flush();
+
     // update old position
-    PanelPiece_invalidatePiece((mHotPiece*)child, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 
     if ((item = _c(self)->searchItem(self, child))) {
         item->normalVector.angle = (angle >= ROTATE_90 * 2) ? 0.0 : angle;
@@ -928,7 +1060,7 @@ static void mPanelPiece_rotatePiece(mPanelPiece *self, mHotPiece *child, float a
     }
 
     // update new position
-    PanelPiece_invalidatePiece((mHotPiece*)child, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 }
 
 static MGEFF_ANIMATION mPanelPiece_rotatePieceWithAnimation(mPanelPiece *self, mHotPiece *child,
@@ -936,21 +1068,21 @@ static MGEFF_ANIMATION mPanelPiece_rotatePieceWithAnimation(mPanelPiece *self, m
 {
     MGEFF_ANIMATION anim = NULL;
     mPieceItem *item = NULL;
-    float s, e;
     if ((item = _c(self)->searchItem(self, child))) {
-        anim = mGEffAnimationCreate(child, _piece_anim_cb, ANIM_ROTATE, MGEFF_FLOAT);
-        assert(anim);
+        float from[2], to[2];
 
-        s = item->normalVector.angle;
-	e = angle;
+        PieceAnim_flush();
+        from[0] = item->normalVector.angle;
+        from[1] = 0.0;
+        to[0] = angle;
+        to[1] = 0.0;
         item->normalVector.x = x;
         item->normalVector.y = y;
         item->normalVector.z = z;
 
-        mGEffAnimationSetStartValue(anim, &s);
-        mGEffAnimationSetEndValue(anim, &e);
-        mGEffAnimationSetDuration(anim, duration);
-        mGEffAnimationSetCurve(anim, curve);
+        anim = PieceAnim_create((mHotPiece*)self, item, PIECEANIM_ROTATE,
+                from, to, duration, curve);
+        assert(anim);
         return anim;
     }
     return NULL;
@@ -962,15 +1094,17 @@ static void mPanelPiece_setPieceAlpha(mPanelPiece *self, mHotPiece *child, int a
 {
     mPieceItem *item = NULL;
 
+    PieceAnim_flush();
+
     // update old position
-    PanelPiece_invalidatePiece((mHotPiece*)child, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 
     if ((item = _c(self)->searchItem(self, child))) {
         item->alpha = alpha;
     }
 
     // update new position
-    PanelPiece_invalidatePiece((mHotPiece*)child, NULL);
+    _c(self)->invalidatePiece(self, child, NULL, TRUE);
 }
 
 static MGEFF_ANIMATION mPanelPiece_setPieceAlphaWithAnimation(mPanelPiece *self, mHotPiece *child,
@@ -979,37 +1113,85 @@ static MGEFF_ANIMATION mPanelPiece_setPieceAlphaWithAnimation(mPanelPiece *self,
     MGEFF_ANIMATION anim = NULL;
     mPieceItem *item = NULL;
     if ((item = _c(self)->searchItem(self, child))) {
-        anim = mGEffAnimationCreate(child, _piece_anim_cb, ANIM_ALPHA, MGEFF_INT);
-        assert(anim);
+        float from[2], to[2];
+
+        PieceAnim_flush();
+        from[0] = item->alpha;
+        from[1] = 0.0;
+        to[0] = alpha;
+        to[1] = 0.0;
 
-        mGEffAnimationSetStartValue(anim, &item->alpha);
-        mGEffAnimationSetEndValue(anim, &alpha);
-        mGEffAnimationSetDuration(anim, duration);
-        mGEffAnimationSetCurve(anim, curve);
+        anim = PieceAnim_create((mHotPiece*)self, item, PIECEANIM_ALPHA,
+                from, to, duration, curve);
+        assert(anim);
         return anim;
     }
     return NULL;
 }
 /****************************ALPHA PIECE END***********************************/
 
-typedef struct {
-    list_t list;
+struct _PANEL_EVENT_HANDLER {
     int message;
     NCS_PIECE_EVENT_HANDLER handler;
-} event_handler_t;
+};
+
+/* one bit per message bucket, clear means no handler for any message in it */
+#define EVENT_MASK_BIT(message) (1UL << ((unsigned)(message) & 31))
+
+static BOOL s_itemHitTest(void *data, int x, int y, void *ctx)
+{
+    RECT rc;
+
+    /* check the live rect, the child may have been resized since indexed */
+    s_getItemRect((mPieceItem*)data, &rc);
+    return PtInRect(&rc, x, y);
+}
+
+static void s_syncSpatialIndex(mPanelPiece *self)
+{
+    ITEM_CURSOR cursor;
+    mPieceItem *item;
+    RECT rc;
+    int order = 0;
+
+    if (SpatialIndex_isValid(self->spatialIndex))
+        return;
+
+    _c(self)->getRect(self, &rc);
+    SpatialIndex_reset(self->spatialIndex, rc.right, rc.bottom);
+
+    FOR_EACH_ITEM(self->itemManager, cursor, item) {
+        s_getItemRect(item, &rc);
+        SpatialIndex_insert(self->spatialIndex, item, order++, &rc);
+    }
+}
 
 static mPieceItem *itemAt(mPanelPiece* self, int x, int y)
 {
     mPieceItem *item = NULL;
 
+    PanelPiece_flushLayout(self);
+    if (self->spatialIndex
+            && x >= self->left && x < self->right
+            && y >= self->top && y < self->bottom) {
+        s_syncSpatialIndex(self);
+        if (SpatialIndex_isValid(self->spatialIndex)) {
+            item = (mPieceItem*)SpatialIndex_query(self->spatialIndex, x, y,
+                    s_itemHitTest, NULL);
+            if (item)
+                return item;
+        }
+        /* out of memory, or a child that is not a panel grew over x, y
+         * through its own setRect and is not in this cell of the grid */
+    }
+
     if(x >= self->left && x < self->right
             && y >= self->top && y < self->bottom)
     {
         RECT rc;
-        //TODO: we should use reverse_iterator here
-        mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
+        ITEM_CURSOR cursor;
         mHotPiece *piece;
-        while ((item = _c(iter)->prev(iter))) {
+        FOR_EACH_ITEM_REVERSE(self->itemManager, cursor, item) {
             piece = item->piece;;
             assert(piece);
 
@@ -1020,7 +1202,6 @@ static mPieceItem *itemAt(mPanelPiece* self, int x, int y)
                 }
             }
         }
-        DELETE(iter);
     }
     return item;
 }
@@ -1030,50 +1211,98 @@ static mHotPiece * mPanelPiece_childAt(mPanelPiece* self, int x, int y) {
     return item ? item->piece : NULL;
 }
 
+/* index of the first handler whose message is not less than message */
+static int s_lowerHandler(mPanelPiece *self, int message)
+{
+    int low = 0, high = self->nr_eventHandlers;
+
+    while (low < high) {
+        int mid = (low + high) >> 1;
+        if (self->eventHandlers[mid].message < message)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
 static void mPanelPiece_appendEventHandler(mPanelPiece *self,
         int message, NCS_PIECE_EVENT_HANDLER handler) {
-    event_handler_t *entry;
-    entry = (event_handler_t *)calloc(1, sizeof(*entry));
-    entry->message = message;
-    entry->handler = handler;
-    list_add(&entry->list, self->eventHandlers.prev);
+    int i;
+
+    if (!handler)
+        return;
+
+    if (self->nr_eventHandlers == self->max_eventHandlers) {
+        int max = self->max_eventHandlers ? self->max_eventHandlers * 2 : 4;
+        PANEL_EVENT_HANDLER *handlers = (PANEL_EVENT_HANDLER*)realloc(
+                self->eventHandlers, max * sizeof(PANEL_EVENT_HANDLER));
+        if (!handlers)
+            return;
+        self->eventHandlers = handlers;
+        self->max_eventHandlers = max;
+    }
+
+    /* after the handlers already added for message, they run in order */
+    i = s_lowerHandler(self, message + 1);
+    memmove(self->eventHandlers + i + 1, self->eventHandlers + i,
+            (self->nr_eventHandlers - i) * sizeof(PANEL_EVENT_HANDLER));
+    self->eventHandlers[i].message = message;
+    self->eventHandlers[i].handler = handler;
+    self->nr_eventHandlers ++;
+    self->eventMask |= EVENT_MASK_BIT(message);
 }
 
 static void mPanelPiece_delEventHandler(mPanelPiece *self, int message)
 {
-    list_t *i;
-    list_for_each(i, &self->eventHandlers) {
-        event_handler_t *entry = (event_handler_t*)i;
-        if (entry->message == message) {
-            free(entry);
-            list_del(i);
-        }
-    }
+    int first, last, i;
+
+    first = s_lowerHandler(self, message);
+    for (last = first; last < self->nr_eventHandlers
+            && self->eventHandlers[last].message == message; last ++);
+    if (last == first)
+        return;
+
+    memmove(self->eventHandlers + first, self->eventHandlers + last,
+            (self->nr_eventHandlers - last) * sizeof(PANEL_EVENT_HANDLER));
+    self->nr_eventHandlers -= last - first;
+
+    self->eventMask = 0;
+    for (i = 0; i < self->nr_eventHandlers; i ++)
+        self->eventMask |= EVENT_MASK_BIT(self->eventHandlers[i].message);
 }
 
 static void mPanelPiece_clearEventHandler(mPanelPiece *self)
 {
-    list_t *i, *n;
-    list_for_each_safe(i, n, &self->eventHandlers) {
-        list_del(i);
-        free(i);
-    }
+    free(self->eventHandlers);
+    self->eventHandlers = NULL;
+    self->nr_eventHandlers = 0;
+    self->max_eventHandlers = 0;
+    self->eventMask = 0;
 }
 
-static NCS_PIECE_EVENT_HANDLER find_event_handle(mPanelPiece *self, int message) {
-    list_t *list;
-    list_for_each(list, &self->eventHandlers) {
-        event_handler_t *entry = (event_handler_t *)list;
-        if (entry->message == message) {
-            return entry->handler;
-        }
+/* runs the handlers of message in the order they were appended,
+ * returns TRUE once one of them handles it */
+static BOOL s_callEventHandlers(mPanelPiece *self, int message,
+        WPARAM wParam, LPARAM lParam, mObject *owner)
+{
+    int i;
+
+    if (!(self->eventMask & EVENT_MASK_BIT(message)))
+        return FALSE;
+
+    for (i = s_lowerHandler(self, message); i < self->nr_eventHandlers
+            && self->eventHandlers[i].message == message; i ++) {
+        if (self->eventHandlers[i].handler((mHotPiece *)self,
+                    message, wParam, lParam, owner) >= 0)
+            return TRUE;
     }
-    return NULL;
+    return FALSE;
 }
 
 static int mPanelPiece_processMessage(mPanelPiece *self, int message, WPARAM wParam, LPARAM lParam, mObject *owner)
 {
-    NCS_PIECE_EVENT_HANDLER handler = NULL;
+    BOOL hasHandler = FALSE;
 #ifdef HOVER
     mHotPiece *hotfocus;
 #endif
@@ -1084,17 +1313,17 @@ static int mPanelPiece_processMessage(mPanelPiece *self, int message, WPARAM wPa
         case MSG_LBUTTONDOWN:
         case MSG_LBUTTONUP:
         case MSG_MOUSEMOVE:
-            handler = find_event_handle(self, message);
+            hasHandler = TRUE;
             break;
         default:
             if (message >= MSG_USER)
-                handler = find_event_handle(self, message);
+                hasHandler = TRUE;
             break;
     }
 
-    if (handler
+    if (hasHandler
             && (message != MSG_MOUSEMOVEIN || (mObject*)self != mWidget_getHoveringFocus((mWidget*)owner))
-            && handler((mHotPiece *)self, message, wParam, lParam, owner) >= 0) {
+            && s_callEventHandlers(self, message, wParam, lParam, owner)) {
         return 0;
     }
 
@@ -1154,26 +1383,70 @@ static int mPanelPiece_processMessage(mPanelPiece *self, int message, WPARAM wPa
     return 0;
 }
 
+#ifndef MGEFF_INFINITE
+#define MGEFF_INFINITE  99999999
+#endif
+
+/* length of one loop of the frame clock, it only bounds how long the
+ * clock takes to wind down, the callback runs on every scheduler tick */
+#define FRAME_CLOCK_PERIOD      100
+/* ticks without damage after the deadline before the clock stops */
+#define FRAME_CLOCK_IDLE_TICKS  4
+
 static void _update_callback(MGEFF_ANIMATION handle, void *target, intptr_t id, void *value)
 {
     mPanelPiece *self = (mPanelPiece*)target;
     assert (self && self->owner);
 
+    /* the piece animations of this tick, they invalidate what they move */
+    PieceAnim_flush();
+
     if (self->update_flag) {
         self->update_flag = FALSE;
+        self->clockIdleTicks = 0;
         PanelPiece_update((mHotPiece*)self, TRUE);
     }
+    else if ((int)(GetTickCount() - self->clockDeadline) >= 0
+            && ++self->clockIdleTicks == FRAME_CLOCK_IDLE_TICKS) {
+        /* let the clock finish its current loop instead of stopping it
+         * from its own callback */
+        mGEffAnimationSetProperty(handle, MGEFF_PROP_LOOPCOUNT,
+                mGEffAnimationGetProperty(handle, MGEFF_PROP_CURLOOP) + 1);
+    }
 }
 
 static void _update_finished_cb(MGEFF_ANIMATION handle)
 {
     mPanelPiece* self = (mPanelPiece*) mGEffAnimationGetContext(handle);
     self->update_anim = NULL;
+    FrameStats_clockStopped();
+}
+
+static void s_runFrameClock(mPanelPiece *self, int duration)
+{
+    /* GetTickCount counts in 10ms */
+    DWORD deadline = GetTickCount() + (duration + 9) / 10;
+
+    if ((int)(deadline - self->clockDeadline) > 0 || !self->update_anim)
+        self->clockDeadline = deadline;
+    self->clockIdleTicks = 0;
+
+    if (self->update_anim) {
+        /* it may be winding down */
+        mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_LOOPCOUNT, MGEFF_INFINITE);
+        return;
+    }
+
+    FrameStats_clockStarted();
+    self->update_anim = mGEffAnimationCreate(self, _update_callback, (intptr_t)(self+1), MGEFF_INT);
+    mGEffAnimationSetDuration(self->update_anim, FRAME_CLOCK_PERIOD);
+    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_LOOPCOUNT, MGEFF_INFINITE);
+    mGEffAnimationSetFinishedCb(self->update_anim, _update_finished_cb);
+    mGEffAnimationSetContext(self->update_anim, self);
+    mGEffAnimationAsyncRun(self->update_anim);
+    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_KEEPALIVE, 0);
 }
 
-#ifndef MGEFF_INFINITE
-#define MGEFF_INFINITE  99999999
-#endif
 
 static void mPanelPiece_setOwner(mPanelPiece* self, mWidget* owner)
 {
@@ -1207,82 +1480,27 @@ static void mPanelPiece_animationAsyncRun(mPanelPiece *self, MGEFF_ANIMATION ani
 {
     /* assert (PanelPiece_isTopPanel(self)); */
     self = PanelPiece_getTopPanel((mHotPiece*)self);
-    
-    // stop current update animation if exists
-    if (self->update_anim)
-        mGEffAnimationStop(self->update_anim);
-    // create a new update animation
-    self->update_anim = mGEffAnimationCreate(self, _update_callback, (intptr_t)(self+1), MGEFF_INT);
-    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_LOOPCOUNT, MGEFF_INFINITE);
-    mGEffAnimationSetFinishedCb(self->update_anim, _update_finished_cb);
-    mGEffAnimationSetContext(self->update_anim, self);
-
-    
-#ifdef ENABLE_ANIM_FPS_TEST
-    anim_fps_test_start (1);
-#endif
 
     // run user's animation
     mGEffAnimationAsyncRun(anim);
     mGEffAnimationSetProperty(anim, MGEFF_PROP_KEEPALIVE, keepalive);
 
-    // run update_anim after user's anim, so it will be the last one in the schedular queue
-    mGEffAnimationAsyncRun(self->update_anim);
-    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_KEEPALIVE, 0);
+    // the shared frame clock paints what it changed
+    s_runFrameClock(self, mGEffAnimationGetDuration(anim));
 }
 
 static void mPanelPiece_animationSyncRunAndDelete(mPanelPiece *self, MGEFF_ANIMATION anim)
 {
-    // get loopcount & duration from user's animation
-    //int loopcount;
-    int duration;
-
     /* assert(PanelPiece_isTopPanel(self)); */
     self = PanelPiece_getTopPanel((mHotPiece*)self);
     
     if (anim == NULL)
         return;
 
-    //loopcount = mGEffAnimationGetProperty(anim, MGEFF_PROP_LOOPCOUNT);
-    duration = mGEffAnimationGetDuration(anim);
-
-    // stop current update animation if exists
-    if (self->update_anim)
-        mGEffAnimationStop(self->update_anim);
-    // create a new update animation
-    self->update_anim = mGEffAnimationCreate(self, _update_callback, (intptr_t)(self+1), MGEFF_INT);
-#if 1
-    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_LOOPCOUNT, MGEFF_INFINITE);
-#else
-    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_LOOPCOUNT, loopcount);
-#endif
-    mGEffAnimationSetDuration(self->update_anim, duration);
-    mGEffAnimationSetFinishedCb(self->update_anim, _update_finished_cb);
-    mGEffAnimationSetContext(self->update_anim, self);
-
-#if 1
-
-#ifdef ENABLE_ANIM_FPS_TEST
-    anim_fps_test_start (1);
-#endif
-
-    mGEffAnimationAsyncRun(self->update_anim);
-    mGEffAnimationSetProperty(self->update_anim, MGEFF_PROP_KEEPALIVE, 0);
+    s_runFrameClock(self, mGEffAnimationGetDuration(anim));
     mGEffAnimationSyncRun(anim);
     mGEffAnimationDelete(anim);
-#else
-    // create a new animgrp
-    self->animgrp = mGEffAnimationCreateGroup(MGEFF_PARALLEL);
-
-    // add user's animation
-    mGEffAnimationAddToGroup(self->animgrp, anim);
-    // add update_anim after user's anim, so it will be the last one in the schedular queue
-    mGEffAnimationAddToGroup(self->animgrp, self->update_anim);
-
-    // run animation
-    mGEffAnimationSyncRun(self->animgrp);
-    mGEffAnimationDelete(self->animgrp);
-#endif
+    PieceAnim_flush();
 }
 
 mShapeTransRoundPiece* mPanelPiece_getBkgndPiece(mPanelPiece *self)
@@ -1290,6 +1508,20 @@ mShapeTransRoundPiece* mPanelPiece_getBkgndPiece(mPanelPiece *self)
     return self->bkgndPiece;
 }
 
+static BOOL mPanelPiece_getOpaqueRect(mPanelPiece *self, RECT *prc)
+{
+    RECT rc;
+
+    /* the children are not looked at, the background is enough in
+     * practice and much cheaper */
+    if (self->bkgndPiece == NULL
+            || !s_getPieceOpaqueRect((mHotPiece*)self->bkgndPiece, prc))
+        return FALSE;
+
+    _c(self)->getRect(self, &rc);
+    return IntersectRect(prc, prc, &rc);
+}
+
 void mPanelPiece_setBkgndPiece(mPanelPiece *self, mShapeTransRoundPiece* piece)
 {
     if (self->bkgndPiece && self->bkgndPiece != piece) {
@@ -1319,6 +1551,10 @@ static void mPanelPiece_invalidatePiece(mPanelPiece *self, mHotPiece *piece, con
     item = _c(self)->searchItem(self, piece);
     assert(item);
 
+    /* the content of piece changed, its retained layer is stale there */
+    if (!reserveCache)
+        LayerCache_markDirty(item, rc);
+
     /* set dirtyRect if piece has been scaled */
     if (item->wscalefactor != 1 || item->hscalefactor != 1) {
         _c (item->piece)->getRect (item->piece, &dirtyRect);
@@ -1350,13 +1586,15 @@ static void mPanelPiece_invalidatePiece(mPanelPiece *self, mHotPiece *piece, con
     if (parent == (mPanelPiece *)-1) {
         _MG_PRINTF ("%p piece is delContent from parent!!!\n", self);
     }else if (parent) {
-        _c(parent)->invalidatePiece(parent, (mHotPiece *)self, &dirtyRect, reserveCache);
+        /* whatever happened to piece, the content of self has changed */
+        _c(parent)->invalidatePiece(parent, (mHotPiece *)self, &dirtyRect, FALSE);
     }else{
         mWidget* owner;
 
         owner = (mWidget*) ((mPanelPiece*)self)->owner;
         if ( NULL != owner ) {
             OffsetRect(&dirtyRect, parentRC.left, parentRC.top);
+            PanelPiece_addDamageRect(self, &dirtyRect);
             InvalidateRect(owner->hwnd, &dirtyRect, FALSE);
             ((mPanelPiece*)self)->update_flag = TRUE;
         }
@@ -1401,6 +1639,7 @@ BEGIN_MINI_CLASS(mPanelPiece, mStaticPiece)
     CLASS_METHOD_MAP(mPanelPiece, animationAsyncRun)
     CLASS_METHOD_MAP(mPanelPiece, getBkgndPiece)
     CLASS_METHOD_MAP(mPanelPiece, setBkgndPiece)
+    CLASS_METHOD_MAP(mPanelPiece, getOpaqueRect)
     CLASS_METHOD_MAP(mPanelPiece, enableChildCache)
     CLASS_METHOD_MAP(mPanelPiece, updateChildCache)
     CLASS_METHOD_MAP(mPanelPiece, invalidatePiece)
@@ -1421,12 +1660,108 @@ void PanelPiece_invalidatePiece(mHotPiece *piece, const RECT *rc) {
 
         owner = (mWidget*) ((mPanelPiece*)piece)->owner;
         if ( NULL != owner ) {
+            RECT dirtyRect;
+            if (rc) {
+                dirtyRect = *rc;
+            } else {
+                _c(piece)->getRect(piece, &dirtyRect);
+            }
+            PanelPiece_addDamageRect((mPanelPiece*)piece, &dirtyRect);
             InvalidateRect(owner->hwnd, rc, FALSE);
             ((mPanelPiece*)piece)->update_flag = TRUE;
         }
     }
 }
 
+static int s_rectArea(const RECT *rc)
+{
+    return RECTWP(rc) * RECTHP(rc);
+}
+
+/* merging two damage rects pays off when their bounding rect is mostly
+ * made of damage: overlapping rects always, disjoint ones only if the
+ * bounding rect is less than a quarter waste. */
+static BOOL s_shouldMergeDamage(const RECT *a, const RECT *b, RECT *bound)
+{
+    GetBoundRect(bound, a, b);
+    if (DoesIntersect(a, b))
+        return TRUE;
+    return s_rectArea(bound) * 3 <= (s_rectArea(a) + s_rectArea(b)) * 4;
+}
+
+void PanelPiece_addDamageRect(mPanelPiece *topPanel, const RECT *rc)
+{
+    RECT dirty, bound;
+    BOOL merged;
+    int i;
+
+    if (rc == NULL || IsRectEmpty(rc))
+        return;
+
+    dirty = *rc;
+    do {
+        merged = FALSE;
+        for (i = 0; i < topPanel->nr_damage_rects; ++i) {
+            RECT *cur = &topPanel->damageRects[i];
+
+            if (cur->left <= dirty.left && cur->top <= dirty.top
+                    && cur->right >= dirty.right && cur->bottom >= dirty.bottom)
+                return;
+
+            if (s_shouldMergeDamage(cur, &dirty, &bound)) {
+                /* take it out and retry with the union, which may now
+                 * touch the rects checked before */
+                dirty = bound;
+                *cur = topPanel->damageRects[--topPanel->nr_damage_rects];
+                merged = TRUE;
+                break;
+            }
+        }
+
+        if (!merged && topPanel->nr_damage_rects == PANEL_MAX_DAMAGE_RECTS) {
+            /* full: fold into the rect which grows the least */
+            int best = 0;
+            int best_cost = 0;
+
+            for (i = 0; i < topPanel->nr_damage_rects; ++i) {
+                RECT *cur = &topPanel->damageRects[i];
+                int cost;
+
+                GetBoundRect(&bound, cur, &dirty);
+                cost = s_rectArea(&bound) - s_rectArea(cur);
+                if (i == 0 || cost < best_cost) {
+                    best = i;
+                    best_cost = cost;
+                }
+            }
+            GetBoundRect(&dirty, &topPanel->damageRects[best], &dirty);
+            topPanel->damageRects[best] = topPanel->damageRects[--topPanel->nr_damage_rects];
+            merged = TRUE;
+        }
+    } while (merged);
+
+    topPanel->damageRects[topPanel->nr_damage_rects++] = dirty;
+}
+
+void PanelPiece_invalidateSpatialIndex(mPanelPiece *self)
+{
+    SpatialIndex_invalidate(self->spatialIndex);
+}
+
+void PanelPiece_flushLayout(mPanelPiece *self)
+{
+    if (self->layoutDirty) {
+        s_doLayout(self);
+    }
+}
+
+void PanelPiece_runFrameClock(mHotPiece *piece, int duration)
+{
+    mPanelPiece* topPanel = PanelPiece_getTopPanel(piece);
+    if (topPanel)
+        s_runFrameClock(topPanel, duration);
+}
+
 void PanelPiece_update(mHotPiece *piece, BOOL fErase)
 {
     mPanelPiece* topPanel = PanelPiece_getTopPanel(piece);
@@ -1435,10 +1770,19 @@ void PanelPiece_update(mHotPiece *piece, BOOL fErase)
         mWidget* owner = (mWidget*)topPanel->owner;
 
         extern void GUIAPI UpdateInvalidRect (HWND hWnd, BOOL bErase);
-        UpdateInvalidRect(owner->hwnd, fErase);
+        if (INSTANCEOF(owner, mContainerCtrl))
+            ContainerCtrl_schedulePaint((mContainerCtrl*)owner, fErase);
+        else
+            UpdateInvalidRect(owner->hwnd, fErase);
     }
 }
 
+SURFACE_POOL *PanelPiece_getSurfacePool(mHotPiece *piece)
+{
+    assert(INSTANCEOF(piece, mPanelPiece));
+    return s_getSurfacePool((mPanelPiece*)piece);
+}
+
 mPanelPiece *PanelPiece_getTopPanel(mHotPiece *piece)
 {
     mHotPiece *p = piece;
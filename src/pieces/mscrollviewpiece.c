@@ -77,16 +77,15 @@ static mPieceItem* s_getContent(mScrollViewPiece* self)
     if (self->m_content) {
         return self->m_content;
     }else{
-        mItemIterator *iter = _c(self->itemManager)->createItemIterator(self->itemManager);
+        ITEM_CURSOR cursor;
         mPieceItem *item;
        
-        while ((item = _c(iter)->next(iter))) {
+        FOR_EACH_ITEM(self->itemManager, cursor, item) {
             if (item != self->m_scrollbar) {
                 self->m_content = item;
                 break;
             }
         }
-        DELETE(iter);
         return self->m_content;
     }
 }
@@ -499,17 +498,13 @@ static void mScrollViewPiece_construct(mScrollViewPiece *self, DWORD addData) {
     self->m_phy_ctx = NULL;
     {
         mHotPiece *scrollbar;
-        mItemIterator *iter;
 
         scrollbar = (mHotPiece *)NEWPIECE(mShapeTransRoundPiece);
         _c(scrollbar)->setProperty(scrollbar, NCSP_TRANROUND_BKCOLOR, MakeRGBA(0, 0, 0, 0x50));
         _c(scrollbar)->setProperty(scrollbar, NCSP_TRANROUND_RADIUS, 0);
 
-        _c(self)->addContent(self, scrollbar, 0, 0);
-
-        iter = _c(self->itemManager)->createItemIterator(self->itemManager);
-        self->m_scrollbar = _c(iter)->next(iter);
-        DELETE(iter);
+        /* the first item of the panel */
+        self->m_scrollbar = _c(self)->addContent(self, scrollbar, 0, 0);
     }
 
     /* Cache */
@@ -645,7 +640,7 @@ static void s_drawScrollBar(mScrollViewPiece *self, HDC hdc, mObject *owner, DWO
 
 #if 1
     _c(self->m_scrollbar->piece)->setRect(self->m_scrollbar->piece, &sbRc);
-    _c(self->m_scrollbar->piece)->paint(self->m_scrollbar->piece, hdc, owner, add_data);
+    PAINTTRACE_PAINT(self->m_scrollbar->piece, hdc, owner, add_data);
 #else
     SetBrushColor(hdc, RGBA2Pixel(hdc, 0xff, 0, 0, 0xff));
     FillBox(hdc, sbRc.left, sbRc.top, RECTW(sbRc), RECTH(sbRc));
@@ -708,7 +703,7 @@ static void s_updateCache(mScrollViewPiece *self, mPieceItem *child, const RECT
             childDC = GetSubDC(self->m_cache, child->x, child->y, RECTWP(c_whole), RECTHP(c_whole));
             ClipRectIntersect(childDC, &self->m_contentDirtyRect);
 
-            _c(child->piece)->paint(child->piece, childDC, owner, add_data);
+            PAINTTRACE_PAINT(child->piece, childDC, owner, add_data);
             memset(&self->m_contentDirtyRect, 0, sizeof(self->m_contentDirtyRect));
             LOG_TIME("    ");
 
@@ -866,6 +861,7 @@ static void mScrollViewPiece_movePiece(mScrollViewPiece *self, mHotPiece *child,
 
         item->x = x;
         item->y = y;
+        PanelPiece_invalidateSpatialIndex((mPanelPiece*)self);
 
         /* update new position */
         _c(self)->invalidatePiece(self, child, NULL, reserveCache);
@@ -401,9 +401,12 @@ static BOOL mTableViewItemPiece_setRect(mTableViewItemPiece *self, const RECT *p
 
 static void mTableViewItemPiece_setUserPiece(mTableViewItemPiece *self, mHotPiece* piece)
 {
+    if (self->userPiece == piece)
+        return;
+
     /* delete the current userPiece */
     if (self->userPiece) {
-        _c(self)->delContent(self, piece);
+        _c(self)->delContent(self, self->userPiece);
     }
 
     if (piece) {
@@ -35,6 +35,7 @@
 #endif
 
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 
 #include <minigui/common.h>
@@ -53,34 +54,50 @@ static void _piece_anim_cb(MGEFF_ANIMATION handle, void *target, intptr_t id, vo
 static BOOL onIndexLocatePieceTouched(mTableViewPiece *self,
 				      mHotPiece *sender, int event_id, DWORD param);
 static mPieceItem* nextItem(mTableViewPiece* self, mItemIterator* iter, mHotPiece* prev);
+static void autoAdjustTableViewPosition(mTableViewPiece* self);
+
+/* virtualized rows */
+static void* s_reserve(void* base, int* max, int need, size_t size);
+static int s_rowTop(mTableViewPiece* self, int section, int row);
+static int s_rowBottom(mTableViewPiece* self, int section, int row);
+static int s_sectionBottom(mTableViewPiece* self, int section);
+static BOOL s_findRow(mTableViewPiece* self, const mIndexPath* indexpath, int* pos);
+static void s_syncRows(mTableViewPiece* self);
+static void s_measureRow(mTableViewPiece* self, int section, int row);
+static void s_fitRow(mTableViewPiece* self, const mIndexPath* indexpath, mHotPiece* piece);
+static void s_reloadRows(mTableViewPiece* self);
+static void s_resetRows(mTableViewPiece* self);
+static void s_paintSeparators(mTableViewPiece* self, HDC hdc);
 
 static int s_onContentMouseMove(mHotPiece *_self, int message, WPARAM wParam, LPARAM lParam, mObject *owner)
 {
     mTableViewPiece *self = (mTableViewPiece*)(_self->parent);
-    {
-        mItemIterator* section_iter =
-            _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
+    if (self->virtualized) {
+        int i;
+        for (i = 0; i < self->nr_rows; i++) {
+            if (self->rows[i].indexpath.row >= 0) {
+                mTableViewItemPiece* piece = (mTableViewItemPiece*)self->rows[i].piece;
+                _c(piece)->setHighlight(piece, FALSE);
+            }
+        }
+    }
+    else {
+        ITEM_CURSOR section_cursor, row_cursor;
         mPanelPiece* sectionPiece = NULL;
+        mPieceItem* section = NULL;
         mPieceItem* item = NULL;
 
-        assert(NULL != section_iter);
-        while (NULL != (item = _c(section_iter)->next(section_iter))) {
-            mItemIterator* row_iter;
-            sectionPiece = SAFE_CAST(mPanelPiece, _c(item)->getPiece(item));
+        FOR_EACH_ITEM(self->tablePanel->itemManager, section_cursor, section) {
+            sectionPiece = SAFE_CAST(mPanelPiece, _c(section)->getPiece(section));
             assert(NULL != sectionPiece);
 
-            row_iter = 
-                _c(sectionPiece->itemManager)->createItemIterator(sectionPiece->itemManager);
-            while(NULL != (item = _c(row_iter)->next(row_iter))) {
+            FOR_EACH_ITEM(sectionPiece->itemManager, row_cursor, item) {
                 mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item)->getPiece(item);
                 if (_c(item)->getType(item) == NCS_TABLEVIEW_NORMALROWTYPE){
                     _c(piece)->setHighlight(piece, FALSE);
                 }
             }
-            DELETE(row_iter);
         }
-
-        DELETE(section_iter);
     }
     return -1;
 }
@@ -97,7 +114,18 @@ static int s_onContentMousePress(mHotPiece *_self, int message, WPARAM wParam, L
         mPanelPiece* hotGroup = (mPanelPiece*)_c(self->tablePanel)->childAt(self->tablePanel, 
                 x, y);
 
-        if (hotGroup) {
+        if (self->virtualized) {
+            /* rows sit directly in tablePanel */
+            mPieceItem* item = hotGroup ? _c(self->tablePanel)->searchItem(self->tablePanel, (mHotPiece*)hotGroup) : NULL;
+
+            if (item && _c(item)->getType(item) == NCS_TABLEVIEW_NORMALROWTYPE) {
+                mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item)->getPiece(item);
+                _c(self)->itemToIndexPath(self, piece, &indexpath);
+                piece->highlight =_c(self)->willSelectRowAtIndexPath(self, &indexpath);
+                clickPiece = piece;
+            }
+        }
+        else if (hotGroup) {
             mPieceItem* groupItem = _c(self->tablePanel)->searchItem(self->tablePanel, (mHotPiece*)hotGroup);
             mTableViewItemPiece* hotPiece = (mTableViewItemPiece*)_c(hotGroup)->childAt(hotGroup, 
                     x - _c(groupItem)->getX(groupItem),
@@ -118,31 +146,33 @@ static int s_onContentMousePress(mHotPiece *_self, int message, WPARAM wParam, L
         }
     }
     /* resetEditMode.*/
-    {
-        mItemIterator* section_iter =
-            _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
+    if (self->virtualized) {
+        int i;
+        for (i = 0; i < self->nr_rows; i++) {
+            mTableViewItemPiece* piece = (mTableViewItemPiece*)self->rows[i].piece;
+            if (piece != clickPiece && self->rows[i].indexpath.row >= 0) {
+                _c(piece)->resetEditMode(piece);
+            }
+        }
+    }
+    else {
+        ITEM_CURSOR section_cursor, row_cursor;
         mPanelPiece* sectionPiece = NULL;
+        mPieceItem* section = NULL;
         mPieceItem* item = NULL;
 
-        assert(NULL != section_iter);
-        while (NULL != (item = _c(section_iter)->next(section_iter))) {
-            mItemIterator* row_iter;
-            sectionPiece = SAFE_CAST(mPanelPiece, _c(item)->getPiece(item));
+        FOR_EACH_ITEM(self->tablePanel->itemManager, section_cursor, section) {
+            sectionPiece = SAFE_CAST(mPanelPiece, _c(section)->getPiece(section));
             assert(NULL != sectionPiece);
 
-            row_iter = 
-                _c(sectionPiece->itemManager)->createItemIterator(sectionPiece->itemManager);
-            while(NULL != (item = _c(row_iter)->next(row_iter))) {
+            FOR_EACH_ITEM(sectionPiece->itemManager, row_cursor, item) {
                 mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item)->getPiece(item);
                 if (piece != clickPiece 
                         && _c(item)->getType(item) == NCS_TABLEVIEW_NORMALROWTYPE){
                     _c(piece)->resetEditMode(piece);
                 }
             }
-            DELETE(row_iter);
         }
-
-        DELETE(section_iter);
     }
     return -1;
 }
@@ -155,17 +185,27 @@ static int deleteItem(mWidget* self, int message, WPARAM wParam, LPARAM lParam)
         mPieceItem* item2;
         mTableViewPiece* table = (mTableViewPiece*)wParam;
         mHotPiece* sender = (mHotPiece*)lParam;
-        mItemIterator* iter = _c(table->tablePanel->itemManager)->createItemIterator(table->tablePanel->itemManager);
+        ITEM_CURSOR cursor, cursor_group;
+
+        if (table->virtualized) {
+            int i;
+            for (i = 0; i < table->nr_rows; i++) {
+                if (table->rows[i].piece == sender && table->rows[i].indexpath.row >= 0) {
+                    mIndexPath indexpath = table->rows[i].indexpath;
+                    if ((mHotPiece*)table->focusPiece == sender) table->focusPiece = NULL;
+                    _c(table)->onCommitDeleteRowAtIndexPath(table, &indexpath);
+                    break;
+                }
+            }
+            return 0;
+        }
 
-        while((item = _c(iter)->next(iter))) {
+        FOR_EACH_ITEM(table->tablePanel->itemManager, cursor, item) {
             mPanelPiece* group = (mPanelPiece*)_c(item)->getPiece(item);
-            mItemIterator* iter_group;
 
             assert(INSTANCEOF(group, mPanelPiece));
 
-            iter_group = _c(group->itemManager)->createItemIterator(group->itemManager);
-
-            while((item2 = _c(iter_group)->next(iter_group))){
+            FOR_EACH_ITEM(group->itemManager, cursor_group, item2) {
                 mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item2)->getPiece(item2);
                 if ((mHotPiece*)piece == sender) {
                     if (_c(item2)->getType(item2) == NCS_TABLEVIEW_NORMALROWTYPE) {
@@ -181,9 +221,7 @@ static int deleteItem(mWidget* self, int message, WPARAM wParam, LPARAM lParam)
                     }
                 }
             }
-            DELETE(iter_group);
         }
-        DELETE(iter);
     }
     return 0;
 }
@@ -204,17 +242,32 @@ static BOOL onDeletePieceClicked(mTableViewPiece *self, mHotPiece *sender, int e
 static BOOL onContentPieceClicked(mTableViewPiece *self, mHotPiece* sender, int event_id, DWORD param)
 {
     mPieceItem* item, *item2;
-    mItemIterator* iter = _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
+    ITEM_CURSOR cursor, cursor_group;
 
     assert(event_id == NCSN_TABLEVIEWITEMPIECE_CONTENTCLICKED);
 
-    while((item = _c(iter)->next(iter))) {
+    if (self->virtualized) {
+        int i;
+        for (i = 0; i < self->nr_rows; i++) {
+            mTableViewItemPiece* piece = (mTableViewItemPiece*)self->rows[i].piece;
+            if (self->rows[i].indexpath.row >= 0) {
+                _c(piece)->resetEditMode(piece);
+                if (piece == (mTableViewItemPiece*)sender) {
+                    mIndexPath indexpath = self->rows[i].indexpath;
+                    _c(self)->rowDidSelectAtIndexPath(self, &indexpath);
+                    PanelPiece_update((mHotPiece*)self, TRUE);
+                    break;
+                }
+            }
+        }
+        return TRUE;
+    }
+
+    FOR_EACH_ITEM(self->tablePanel->itemManager, cursor, item) {
         mPanelPiece* group = (mPanelPiece*)_c(item)->getPiece(item);
-        mItemIterator* iter_group;
         assert(INSTANCEOF(group, mPanelPiece));
 
-        iter_group = _c(group->itemManager)->createItemIterator(group->itemManager);
-        while((item2 = _c(iter_group)->next(iter_group))) {
+        FOR_EACH_ITEM(group->itemManager, cursor_group, item2) {
             mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item2)->getPiece(item2);
             if (_c(item2)->getType(item2) == NCS_TABLEVIEW_NORMALROWTYPE){
                 _c(piece)->resetEditMode(piece);
@@ -226,12 +279,21 @@ static BOOL onContentPieceClicked(mTableViewPiece *self, mHotPiece* sender, int
                 }
             }
         }
-        DELETE(iter_group);
     }
-    DELETE(iter);
     return TRUE;
 }
 
+/* tablePanel stacks the section panels, unless the table is virtualized */
+static void s_setSectionLayout(mTableViewPiece* self)
+{
+    mLineVBox* box = (mLineVBox*)NEW(mLineVBox);
+
+    if (self->style == NCS_TABLEVIEW_GROUP_STYLE) {
+        _c(box)->setGap(box, NCS_TABLEVIEW_GROUPGAP);
+    }
+    _c(self->tablePanel)->setLayoutManager(self->tablePanel, (mLayoutManager*)box);
+}
+
 static void mTableViewPiece_construct(mTableViewPiece *self, DWORD add_data)
 {
     Class(mScrollViewPiece).construct((mScrollViewPiece*)self, add_data);
@@ -249,12 +311,8 @@ static void mTableViewPiece_construct(mTableViewPiece *self, DWORD add_data)
 
     self->tablePanel = NEWPIECE(mPanelPiece);
     if (self->tablePanel) {
-        mLineVBox* box = (mLineVBox*)NEW(mLineVBox);
-        _c(self->tablePanel)->setLayoutManager(self->tablePanel, (mLayoutManager*)box);
+        s_setSectionLayout(self);
         _c(self)->addContent(self, (mHotPiece*)self->tablePanel, 0, 0);
-        if (self->style == NCS_TABLEVIEW_GROUP_STYLE) {   
-            _c(box)->setGap(box, NCS_TABLEVIEW_GROUPGAP);
-        }
         _c(self->tablePanel)->appendEventHandler(self->tablePanel, MSG_LBUTTONDOWN, s_onContentMousePress);
         //_c(self->tablePanel)->appendEventHandler(self->tablePanel, MSG_LBUTTONUP, s_onContentMouseUp);
         _c(self->tablePanel)->appendEventHandler(self->tablePanel, MSG_MOUSEMOVE, s_onContentMouseMove);
@@ -262,6 +320,7 @@ static void mTableViewPiece_construct(mTableViewPiece *self, DWORD add_data)
     _c(self)->setSeparatorStyle(self, NCS_TABLEVIEW_SEPARATORSTYLE_SINGLINE);
     _c(self)->setSeparatorColor(self, NCS_TABLEVIEW_SEPARATOR_DEFAULTCOLOR);
     self->focusPiece = NULL;
+    self->overscan = NCS_TABLEVIEW_OVERSCAN;
 }
 
 
@@ -296,67 +355,68 @@ static int mTableViewPiece_processMessage(mTableViewPiece *self, int message, WP
 static void mTableViewPiece_changeMode(mTableViewPiece* self)
 {
     /* set all tablepanel item to another mode.*/
-    mItemIterator* section_iter =
-        _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
-    mItemIterator* row_iter;
+    ITEM_CURSOR section_cursor, row_cursor;
     mPanelPiece* sectionPiece = NULL;
+    mPieceItem* section = NULL;
     mPieceItem* item = NULL;
 
-    while (NULL != (item = _c(section_iter)->next(section_iter))) {
-        sectionPiece = SAFE_CAST(mPanelPiece, _c(item)->getPiece(item));
-        assert(NULL != sectionPiece);
+    /* rows materialized later pick the mode up from here */
+    self->mode = (self->mode == NCS_TABLEVIEW_NORMAL ? NCS_TABLEVIEW_EDIT : NCS_TABLEVIEW_NORMAL);
 
-        row_iter = 
-            _c(sectionPiece->itemManager)->createItemIterator(sectionPiece->itemManager);
+    if (self->virtualized) {
+        int i;
+        for (i = 0; i < self->nr_rows; i++) {
+            mTableViewItemPiece* piece = (mTableViewItemPiece*)self->rows[i].piece;
+            if (self->rows[i].indexpath.row >= 0) {
+                _c(piece)->changeMode(piece);
+            }
+        }
+    }
+    else FOR_EACH_ITEM(self->tablePanel->itemManager, section_cursor, section) {
+        sectionPiece = SAFE_CAST(mPanelPiece, _c(section)->getPiece(section));
+        assert(NULL != sectionPiece);
 
-        while(NULL != (item = _c(row_iter)->next(row_iter))) {
+        FOR_EACH_ITEM(sectionPiece->itemManager, row_cursor, item) {
             mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item)->getPiece(item);
             if (_c(item)->getType(item) == NCS_TABLEVIEW_NORMALROWTYPE) {
                 _c(piece)->changeMode(piece);
             }
         }
-
-        DELETE(row_iter);
-        row_iter = NULL;
     }
     _c(self)->invalidatePiece(self, (mHotPiece*)self->tablePanel, NULL, FALSE);
-
-    DELETE(section_iter);
 }
 
 static mTableViewItemPiece* mTableViewPiece_indexPathToItem(mTableViewPiece* self, const mIndexPath* indexpath)
 {
-    mItemIterator* section_iter =
-	_c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
-    mItemIterator* row_iter = NULL;
+    ITEM_CURSOR section_cursor, row_cursor;
     int i = 0, j = 0;
     mPanelPiece* sectionPiece = NULL;
     mPieceItem* item = NULL;
 
     assert(NULL != indexpath);
-    assert(NULL != section_iter);
-    while (NULL != (item = _c(section_iter)->next(section_iter))) {
+    if (self->virtualized) {
+        /* only rows around the viewport exist */
+        return s_findRow(self, indexpath, &i) && indexpath->row >= 0 ?
+            (mTableViewItemPiece*)self->rows[i].piece : NULL;
+    }
+
+    FOR_EACH_ITEM(self->tablePanel->itemManager, section_cursor, item) {
         sectionPiece = SAFE_CAST(mPanelPiece, _c(item)->getPiece(item));
         assert(NULL != sectionPiece);
 
         if (indexpath->section == i++) { // match section.
-            mItemIterator* row_iter = 
-                _c(sectionPiece->itemManager)->createItemIterator(sectionPiece->itemManager);
-            while(NULL != (item = _c(row_iter)->next(row_iter))) {
+            FOR_EACH_ITEM(sectionPiece->itemManager, row_cursor, item) {
                 mTableViewItemPiece* piece = (mTableViewItemPiece*)_c(item)->getPiece(item);
                 if (_c(item)->getType(item) == NCS_TABLEVIEW_NORMALROWTYPE){
                     if (indexpath->row == j++) { // match row.
-                        DELETE(section_iter);
-                        DELETE(row_iter);
                         return piece;
                     }
                 }
             }
+            break;
         }
     }
 
-    DELETE(section_iter);
-    DELETE(row_iter);
     return NULL;
 }
 
@@ -364,16 +424,26 @@ static void mTableViewPiece_itemToIndexPath(mTableViewPiece* self, const mTableV
 {
     int i = 0, j = 0;
     mPieceItem* item = NULL;
-    mItemIterator* row_iter = NULL;
-    mPanelPiece* sectionPiece = SAFE_CAST(mPanelPiece, piece->parent);
-    mItemIterator* section_iter = _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
+    ITEM_CURSOR section_cursor, row_cursor;
+    mPanelPiece* sectionPiece;
 
-    assert(NULL != sectionPiece);
     assert(NULL != indexpath);
     assert(NULL != piece);
-    assert(NULL != section_iter);
 
-    while (NULL != (item = _c(section_iter)->next(section_iter))) {
+    if (self->virtualized) {
+        for (i = 0; i < self->nr_rows; i++) {
+            if (self->rows[i].piece == (mHotPiece*)piece) {
+                *indexpath = self->rows[i].indexpath;
+                break;
+            }
+        }
+        return;
+    }
+
+    sectionPiece = SAFE_CAST(mPanelPiece, piece->parent);
+    assert(NULL != sectionPiece);
+
+    FOR_EACH_ITEM(self->tablePanel->itemManager, section_cursor, item) {
         if (sectionPiece == SAFE_CAST(mPanelPiece, _c(item)->getPiece(item))) {
             indexpath->section = i;
             break;
@@ -381,8 +451,7 @@ static void mTableViewPiece_itemToIndexPath(mTableViewPiece* self, const mTableV
         i++;
     }
 
-    row_iter = _c(sectionPiece->itemManager)->createItemIterator(sectionPiece->itemManager);
-    while(NULL != (item = _c(row_iter)->next(row_iter))) {
+    FOR_EACH_ITEM(sectionPiece->itemManager, row_cursor, item) {
         mTableViewItemPiece* itemPiece = (mTableViewItemPiece*)_c(item)->getPiece(item);
         if (_c(item)->getType(item) == NCS_TABLEVIEW_NORMALROWTYPE){
             if (itemPiece == piece) { // match row.
@@ -392,8 +461,6 @@ static void mTableViewPiece_itemToIndexPath(mTableViewPiece* self, const mTableV
             ++j;
         }
     }
-    DELETE(row_iter);
-    DELETE(section_iter);
 }
 
 
@@ -404,24 +471,34 @@ static void mTableViewPiece_rectForHeaderInSection(mTableViewPiece* self, int se
     mPieceItem* item;
     mPieceItem* headeritem;
     mPieceItem* parentItem = NULL;
-    mItemIterator *iter = _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
-    
-    while((item = _c(iter)->next(iter))){
+    ITEM_CURSOR cursor;
+
+    if (self->virtualized) {
+        if (section >= 0 && section < self->nr_sections) {
+            _c(self->tablePanel)->getRect(self->tablePanel, &rc);
+            SetRect(rect, 0, s_rowTop(self, section, -1),
+                    RECTW(rc), s_rowBottom(self, section, -1));
+        }
+        return;
+    }
+
+    PanelPiece_flushLayout(self->tablePanel);
+    FOR_EACH_ITEM(self->tablePanel->itemManager, cursor, item) {
         if (i++ == section) {
             mPanelPiece* group = (mPanelPiece*)_c(item)->getPiece(item);
-            mItemIterator *iter = _c(group->itemManager)->createItemIterator(group->itemManager);
+            ITEM_CURSOR group_cursor;
             mHotPiece* piece;
 
             assert(INSTANCEOF(group, mPanelPiece));
 
             /* group first is headerpiece. */
-            headeritem = _c(iter)->next(iter);
+            ItemCursor_init(&group_cursor);
+            headeritem = _c(group->itemManager)->cursorNext(group->itemManager, &group_cursor);
             piece = _c(headeritem)->getPiece(headeritem);
             _c(piece)->getRect(piece, &rc);
 
             parentItem = _c((mPanelPiece*)self->tablePanel)->searchItem(
                     (mPanelPiece*)self->tablePanel, (mHotPiece*)group);
-            DELETE(iter);
             break;
         }
     }
@@ -431,7 +508,6 @@ static void mTableViewPiece_rectForHeaderInSection(mTableViewPiece* self, int se
     rect->top    = _c(parentItem)->getY(parentItem) /* + _c(item)->getY(item); */;
     rect->right  = rect->left + RECTW(rc);
     rect->bottom = rect->top  + RECTH(rc);
-    DELETE(iter);
 }
 
 static void mTableViewPiece_rectForRowAtIndexPath(mTableViewPiece* self, const mIndexPath* indexpath, RECT* rect)
@@ -441,6 +517,18 @@ static void mTableViewPiece_rectForRowAtIndexPath(mTableViewPiece* self, const m
     mPanelPiece* parent;
     mPieceItem* item;
     mPieceItem* parentItem;
+
+    if (self->virtualized) {
+        /* known without materializing the row */
+        if (indexpath->section >= 0 && indexpath->section < self->nr_sections
+                && indexpath->row >= 0 && indexpath->row < self->sections[indexpath->section].rows) {
+            s_measureRow(self, indexpath->section, indexpath->row);
+            _c(self->tablePanel)->getRect(self->tablePanel, &rc);
+            SetRect(rect, 0, s_rowTop(self, indexpath->section, indexpath->row),
+                    RECTW(rc), s_rowBottom(self, indexpath->section, indexpath->row));
+        }
+        return;
+    }
     
     piece = (mHotPiece*) _c(self)->indexPathToItem(self, indexpath);
 
@@ -448,6 +536,8 @@ static void mTableViewPiece_rectForRowAtIndexPath(mTableViewPiece* self, const m
         return;
     
     parent = (mPanelPiece*) piece->parent;
+    PanelPiece_flushLayout(self->tablePanel);
+    PanelPiece_flushLayout(parent);
     parentItem = _c(self->tablePanel)->searchItem(self->tablePanel, (mHotPiece*)parent);
     item = _c(parent)->searchItem(parent, (mHotPiece*)piece);
     _c(piece)->getRect(piece, &rc);
@@ -464,9 +554,19 @@ static void mTableViewPiece_rectForSection(mTableViewPiece* self, int section, R
     int i = 0;
     mPieceItem* item;
     mPieceItem* groupItem = NULL;
-    mItemIterator *iter = _c(self->tablePanel->itemManager)->createItemIterator(self->tablePanel->itemManager);
-    
-    while((item = _c(iter)->next(iter))){
+    ITEM_CURSOR cursor;
+
+    if (self->virtualized) {
+        if (section >= 0 && section < self->nr_sections) {
+            _c(self->tablePanel)->getRect(self->tablePanel, &rc);
+            SetRect(rect, 0, s_rowTop(self, section, -1),
+                    RECTW(rc), s_sectionBottom(self, section));
+        }
+        return;
+    }
+
+    PanelPiece_flushLayout(self->tablePanel);
+    FOR_EACH_ITEM(self->tablePanel->itemManager, cursor, item) {
         if (i++ == section) {
             mPanelPiece* group = (mPanelPiece*)_c(item)->getPiece(item);
             groupItem = _c((mPanelPiece*)self->tablePanel)->searchItem(
@@ -482,8 +582,6 @@ static void mTableViewPiece_rectForSection(mTableViewPiece* self, int section, R
         rect->right  = rect->left + RECTW(rc);
         rect->bottom = rect->top  + RECTH(rc);
     }
-
-    DELETE(iter);
 }
 
 #define NCS_TABLEVIEW_ROWHEIGHT 30
@@ -545,10 +643,17 @@ static void mTableViewPiece_reloadData(mTableViewPiece* self)
 {
     int i = 0;
     mPanelPiece* section_piece = NULL;
-    int section_num = _c(self)->numberOfSections(self);
+    int section_num;
 
     self->focusPiece = NULL;
-    _c(self->tablePanel)->clearContents(self->tablePanel);
+    if (self->virtualized) {
+        s_reloadRows(self);
+        section_num = 0;
+    }
+    else {
+        section_num = _c(self)->numberOfSections(self);
+        _c(self->tablePanel)->clearContents(self->tablePanel);
+    }
     for (i = 0; i < section_num ; i ++) {
         mPieceItem* item;
         if (self->style == NCS_TABLEVIEW_GROUP_STYLE) {
@@ -781,6 +886,7 @@ static void mTableViewPiece_destroy(mTableViewPiece *self)
     if (self->indexLocate) {
         DELPIECE(self->indexLocate);
     }
+    s_resetRows(self);
 
     Class(mScrollViewPiece).destroy((mScrollViewPiece*)self);
 }
@@ -797,11 +903,24 @@ static void mTableViewPiece_deleteRowAtIndexPath(
     int v_s = 0;
     int v_e = 0;
     RECT rc;
-    mHotPiece* piece = (mHotPiece*) _c(self)->indexPathToItem(self, indexpath);
-    mPanelPiece* group = (mPanelPiece*)piece->parent;
-    mPieceItem* item = _c(group)->searchItem((mPanelPiece*)group, (mHotPiece*)piece);
-    mWrapPaintPiece* wrap = NEWPIECEEX(mWrapPaintPiece, (DWORD)piece); /* use wrap piece to do deleting effect */
-    MGEFF_ANIMATION  anim = mGEffAnimationCreate(wrap, _piece_anim_cb, 0, MGEFF_POINT);
+    mHotPiece* piece;
+    mPanelPiece* group;
+    mPieceItem* item;
+    mWrapPaintPiece* wrap;
+    MGEFF_ANIMATION  anim;
+
+    if (self->virtualized) {
+        /* the data source has dropped the row, lay the rest out again */
+        s_reloadRows(self);
+        PanelPiece_invalidatePiece((mHotPiece*)self, NULL);
+        return;
+    }
+
+    piece = (mHotPiece*) _c(self)->indexPathToItem(self, indexpath);
+    group = (mPanelPiece*)piece->parent;
+    item = _c(group)->searchItem((mPanelPiece*)group, (mHotPiece*)piece);
+    wrap = NEWPIECEEX(mWrapPaintPiece, (DWORD)piece); /* use wrap piece to do deleting effect */
+    anim = mGEffAnimationCreate(wrap, _piece_anim_cb, 0, MGEFF_POINT);
     assert(anim);
 
     _c(item)->setPiece(item, (mHotPiece*)wrap);
@@ -849,10 +968,25 @@ static void mTableViewPiece_paint(mTableViewPiece* self, HDC hdc, mObject * owne
     LOG_TIME(">> TableView: ");
 
     _c(self)->getRect(self, &containerRc);
-    SelectClipRect(hdc, &containerRc);
+    if (self->isTopPanel) {
+        if (RECTW(self->invalidRect) && RECTH(self->invalidRect))
+            IntersectRect(&containerRc, &containerRc, &self->invalidRect);
+    }
+    else {
+        /* keep the damage forwarded by the parent panel */
+        IntersectRect(&containerRc, &containerRc, &self->clipRect);
+    }
+    if (IsRectEmpty(&containerRc)) {
+        /* as mPanelPiece_paint, the next direct paint covers everything */
+        _c(self)->getRect(self, &self->clipRect);
+        return;
+    }
+    ClipRectIntersect(hdc, &containerRc);
     self->clipRect = containerRc;
 
+    s_syncRows(self);
     Class(mScrollViewPiece).paint((mScrollViewPiece*)self, hdc, owner, add_data);
+    s_paintSeparators(self, hdc);
 
     if (self->indexLocate) {
         HDC subdc;
@@ -867,9 +1001,16 @@ static void mTableViewPiece_paint(mTableViewPiece* self, HDC hdc, mObject * owne
 
 static void mTableViewPiece_setSeparatorStyle(mTableViewPiece* self, enum mTableViewSeparatorStyle style)
 {
+    int i;
+
     assert((style >= NCS_TABLEVIEW_SEPARATORSTYLE_NONE && 
             style < NCS_TABLEVIEW_SEPARATORSTYLE_MAX));
     self->separatorStyle = style;
+
+    /* the row offsets carry the separator height */
+    for (i = 0; i < self->nr_sections; i++)
+        self->sections[i].dirtyFrom = 0;
+    self->sectionsDirtyFrom = 0;
 }
 
 static void mTableViewPiece_setSeparatorColor(mTableViewPiece* self, DWORD color)
@@ -877,6 +1018,60 @@ static void mTableViewPiece_setSeparatorColor(mTableViewPiece* self, DWORD color
     self->separatorColor = color;
 }
 
+static void mTableViewPiece_setVirtualized(mTableViewPiece* self, BOOL virtualized)
+{
+    if (self->virtualized == virtualized)
+        return;
+
+    self->focusPiece = NULL;
+    s_resetRows(self);
+    _c(self->tablePanel)->clearContents(self->tablePanel);
+    self->virtualized = virtualized;
+
+    /* a layout would restack the rows placed by s_syncRows */
+    if (virtualized)
+        _c(self->tablePanel)->setLayoutManager(self->tablePanel, NULL);
+    else
+        s_setSectionLayout(self);
+}
+
+static mTableViewItemPiece* mTableViewPiece_dequeueReusableRow(mTableViewPiece* self, int reuseType)
+{
+    int i;
+    TABLEVIEW_ROW* dequeued;
+
+    dequeued = s_reserve(self->dequeued, &self->max_dequeued, self->nr_dequeued + 1, sizeof(TABLEVIEW_ROW));
+    if (NULL == dequeued)
+        return NULL;
+    self->dequeued = dequeued;
+
+    for (i = self->nr_reuse - 1; i >= 0; i--) {
+        if (self->reuseQueue[i].reuseType == reuseType) {
+            mHotPiece* piece = self->reuseQueue[i].piece;
+
+            /* still referenced, dropped once the row is placed */
+            dequeued[self->nr_dequeued++] = self->reuseQueue[i];
+            self->reuseQueue[i] = self->reuseQueue[--self->nr_reuse];
+            return (mTableViewItemPiece*)piece;
+        }
+    }
+    return NULL;
+}
+
+static void mTableViewPiece_movePiece(mTableViewPiece *self, mHotPiece *child, int x, int y)
+{
+    Class(mScrollViewPiece).movePiece((mScrollViewPiece*)self, child, x, y);
+    if (child == (mHotPiece*)self->tablePanel)
+        s_syncRows(self);
+}
+
+static BOOL mTableViewPiece_setRect(mTableViewPiece *self, const RECT *prc)
+{
+    BOOL ret = Class(mScrollViewPiece).setRect((mScrollViewPiece*)self, prc);
+    s_syncRows(self);
+    return ret;
+}
+
 /* follow is public interface, user need implement these! */
 static void mTableViewPiece_onCommitInsertRowAtIndexPath(mTableViewPiece* self, const mIndexPath* indexpath)
 {
@@ -934,6 +1129,26 @@ static BOOL mTableViewPiece_willSelectRowAtIndexPath(mTableViewPiece* self, cons
     return TRUE;
 }
 
+static int mTableViewPiece_reuseTypeForRow(mTableViewPiece* self, const mIndexPath* indexpath)
+{
+    return 0;
+}
+
+static int mTableViewPiece_heightForRowAtIndexPath(mTableViewPiece* self, const mIndexPath* indexpath)
+{
+    RECT rc;
+
+    if (self->rowHeight > 0)
+        return self->rowHeight;
+    _c(self)->getDefaultRowRect(self, &rc);
+    return RECTH(rc);
+}
+
+static int mTableViewPiece_estimatedHeightForRow(mTableViewPiece* self, const mIndexPath* indexpath)
+{
+    return 0;
+}
+
 BEGIN_MINI_CLASS(mTableViewPiece, mScrollViewPiece)
 CLASS_METHOD_MAP(mTableViewPiece, construct   )
 CLASS_METHOD_MAP(mTableViewPiece, changeMode  )
@@ -942,6 +1157,10 @@ CLASS_METHOD_MAP(mTableViewPiece, destroy     )
 CLASS_METHOD_MAP(mTableViewPiece, paint)
 CLASS_METHOD_MAP(mTableViewPiece, setSeparatorStyle)
 CLASS_METHOD_MAP(mTableViewPiece, setSeparatorColor)
+CLASS_METHOD_MAP(mTableViewPiece, setVirtualized)
+CLASS_METHOD_MAP(mTableViewPiece, dequeueReusableRow)
+CLASS_METHOD_MAP(mTableViewPiece, movePiece)
+CLASS_METHOD_MAP(mTableViewPiece, setRect)
 CLASS_METHOD_MAP(mTableViewPiece, rectForHeaderInSection)
 CLASS_METHOD_MAP(mTableViewPiece, rectForRowAtIndexPath)
 CLASS_METHOD_MAP(mTableViewPiece, rectForSection)
@@ -965,6 +1184,9 @@ CLASS_METHOD_MAP(mTableViewPiece, numberOfRowsInSection)
 CLASS_METHOD_MAP(mTableViewPiece, titleForSection)
 CLASS_METHOD_MAP(mTableViewPiece, indexForSection)
 CLASS_METHOD_MAP(mTableViewPiece, rowDidSelectAtIndexPath)
+CLASS_METHOD_MAP(mTableViewPiece, reuseTypeForRow)
+CLASS_METHOD_MAP(mTableViewPiece, heightForRowAtIndexPath)
+CLASS_METHOD_MAP(mTableViewPiece, estimatedHeightForRow)
 END_MINI_CLASS
 
 
@@ -1074,3 +1296,534 @@ static mPieceItem* nextItem(mTableViewPiece* self, mItemIterator* iter, mHotPiec
 
     return result;
 }
+
+/* virtualized rows: only the rows around the viewport are pieces, the
+ * rest of the table is the geometry kept in self->sections. */
+
+#define NCS_TABLEVIEW_MIN_ROWS  16
+
+static void* s_reserve(void* base, int* max, int need, size_t size)
+{
+    int m;
+
+    if (need <= *max)
+        return base;
+
+    m = *max ? *max : NCS_TABLEVIEW_MIN_ROWS;
+    while (m < need)
+        m *= 2;
+    if ((base = realloc(base, m * size)))
+        *max = m;
+    return base;
+}
+
+static inline int s_separatorHeight(mTableViewPiece* self)
+{
+    return self->separatorStyle == NCS_TABLEVIEW_SEPARATORSTYLE_SINGLINE ? 1 : 0;
+}
+
+static int s_sectionHeight(mTableViewPiece* self, const TABLEVIEW_SECTION* sec)
+{
+    if (sec->rows == 0)
+        return sec->headerHeight;
+    /* top border, rows with their separators */
+    return sec->headerHeight + s_separatorHeight(self) + sec->rowOffsets[sec->rows];
+}
+
+/* bring the offsets and the section tops up to date, tablePanel follows
+ * the content height so the scroll extent is the estimated one. */
+static void s_updateSections(mTableViewPiece* self)
+{
+    int i, top;
+    int sep = s_separatorHeight(self);
+
+    if (self->sectionsDirtyFrom >= self->nr_sections)
+        return;
+
+    i = self->sectionsDirtyFrom;
+    top = 0;
+    if (i > 0)
+        top = self->sections[i - 1].top + s_sectionHeight(self, &self->sections[i - 1]);
+
+    for (; i < self->nr_sections; i++) {
+        TABLEVIEW_SECTION* sec = &self->sections[i];
+        int row;
+
+        for (row = sec->dirtyFrom; row < sec->rows; row++)
+            sec->rowOffsets[row + 1] = sec->rowOffsets[row] + sec->rowHeights[row] + sep;
+        sec->dirtyFrom = sec->rows;
+
+        if (i > 0 && self->style == NCS_TABLEVIEW_GROUP_STYLE)
+            top += NCS_TABLEVIEW_GROUPGAP;
+        sec->top = top;
+        top += s_sectionHeight(self, sec);
+    }
+    self->sectionsDirtyFrom = self->nr_sections;
+
+    if (top != self->contentHeight) {
+        RECT rc;
+        self->contentHeight = top;
+        _c(self->tablePanel)->getRect(self->tablePanel, &rc);
+        rc.bottom = rc.top + top;
+        _c(self->tablePanel)->setRect(self->tablePanel, &rc);
+    }
+}
+
+/* replace the estimate with the height from the data source */
+static void s_measureRow(mTableViewPiece* self, int section, int row)
+{
+    TABLEVIEW_SECTION* sec = &self->sections[section];
+
+    if (!sec->measured[row]) {
+        mIndexPath indexpath = {section, row};
+        int height = _c(self)->heightForRowAtIndexPath(self, &indexpath);
+
+        sec->measured[row] = TRUE;
+        if (height != sec->rowHeights[row]) {
+            sec->rowHeights[row] = height;
+            sec->dirtyFrom = MIN(sec->dirtyFrom, row);
+            self->sectionsDirtyFrom = MIN(self->sectionsDirtyFrom, section);
+        }
+    }
+}
+
+/* the default heightForRowAtIndexPath only guesses, so the piece of the row
+ * gives its height. otherwise the piece takes the height of the table */
+static void s_fitRow(mTableViewPiece* self, const mIndexPath* indexpath, mHotPiece* piece)
+{
+    TABLEVIEW_SECTION* sec = &self->sections[indexpath->section];
+    int row = indexpath->row;
+    RECT rc;
+
+    _c(piece)->getRect(piece, &rc);
+    if (_c(self)->heightForRowAtIndexPath == mTableViewPiece_heightForRowAtIndexPath
+            && self->rowHeight <= 0 && RECTH(rc) > 0) {
+        if (RECTH(rc) != sec->rowHeights[row]) {
+            sec->rowHeights[row] = RECTH(rc);
+            sec->dirtyFrom = MIN(sec->dirtyFrom, row);
+            self->sectionsDirtyFrom = MIN(self->sectionsDirtyFrom, indexpath->section);
+        }
+    }
+    else if (RECTH(rc) != sec->rowHeights[row]) {
+        rc.bottom = rc.top + sec->rowHeights[row];
+        _c(piece)->setRect(piece, &rc);
+    }
+}
+
+/* row -1 is the section header */
+static int s_rowTop(mTableViewPiece* self, int section, int row)
+{
+    const TABLEVIEW_SECTION* sec = &self->sections[section];
+
+    s_updateSections(self);
+    if (row < 0)
+        return sec->top;
+    return sec->top + sec->headerHeight + s_separatorHeight(self) + sec->rowOffsets[row];
+}
+
+static int s_rowBottom(mTableViewPiece* self, int section, int row)
+{
+    const TABLEVIEW_SECTION* sec = &self->sections[section];
+
+    if (row < 0)
+        return s_rowTop(self, section, row) + sec->headerHeight;
+    return s_rowTop(self, section, row) + sec->rowHeights[row];
+}
+
+static int s_sectionBottom(mTableViewPiece* self, int section)
+{
+    int top = s_rowTop(self, section, -1);
+    return top + s_sectionHeight(self, &self->sections[section]);
+}
+
+static int s_compareRow(const mIndexPath* a, const mIndexPath* b)
+{
+    if (a->section != b->section)
+        return a->section - b->section;
+    return a->row - b->row;
+}
+
+/* self->rows is sorted by indexpath, pos is the insert point when not found */
+static BOOL s_findRow(mTableViewPiece* self, const mIndexPath* indexpath, int* pos)
+{
+    int lo = 0, hi = self->nr_rows;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (s_compareRow(&self->rows[mid].indexpath, indexpath) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *pos = lo;
+    return lo < self->nr_rows && s_compareRow(&self->rows[lo].indexpath, indexpath) == 0;
+}
+
+static BOOL s_nextRow(mTableViewPiece* self, mIndexPath* indexpath)
+{
+    if (indexpath->row + 1 < self->sections[indexpath->section].rows) {
+        ++indexpath->row;
+        return TRUE;
+    }
+    while (++indexpath->section < self->nr_sections) {
+        const TABLEVIEW_SECTION* sec = &self->sections[indexpath->section];
+        if (sec->headerHeight > 0 || sec->rows > 0) {
+            indexpath->row = sec->headerHeight > 0 ? -1 : 0;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* the first row or header whose bottom is below y */
+static BOOL s_locateRow(mTableViewPiece* self, int y, mIndexPath* indexpath)
+{
+    int lo = 0, hi = self->nr_sections;
+    const TABLEVIEW_SECTION* sec;
+
+    if (self->nr_sections == 0)
+        return FALSE;
+
+    s_updateSections(self);
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (self->sections[mid].top <= y)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    sec = &self->sections[lo];
+    indexpath->section = lo;
+    indexpath->row = -1;
+    if (sec->headerHeight > 0 && y < s_rowBottom(self, lo, -1))
+        return TRUE;
+
+    if (sec->rows > 0) {
+        int y_rows = y - sec->top - sec->headerHeight - s_separatorHeight(self);
+
+        /* last row starting at or above y */
+        lo = 0;
+        hi = sec->rows;
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (sec->rowOffsets[mid] <= y_rows)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        indexpath->row = lo;
+        if (s_rowBottom(self, indexpath->section, lo) > y)
+            return TRUE;
+    }
+    return s_nextRow(self, indexpath);
+}
+
+static void s_releaseDequeued(mTableViewPiece* self)
+{
+    /* the rows the data source took are referenced by tablePanel now */
+    while (self->nr_dequeued > 0) {
+        mHotPiece* piece = self->dequeued[--self->nr_dequeued].piece;
+        UNREFPIECE(piece);
+    }
+}
+
+static void s_recycleRow(mTableViewPiece* self, int pos)
+{
+    TABLEVIEW_ROW* row = &self->rows[pos];
+
+    if ((mHotPiece*)self->focusPiece == row->piece)
+        self->focusPiece = NULL;
+
+    if (row->indexpath.row >= 0) {
+        TABLEVIEW_ROW* queue = s_reserve(self->reuseQueue, &self->max_reuse,
+                self->nr_reuse + 1, sizeof(TABLEVIEW_ROW));
+        if (queue) {
+            mTableViewItemPiece* piece = (mTableViewItemPiece*)row->piece;
+
+            self->reuseQueue = queue;
+            _c(piece)->resetEditMode(piece);
+            ADDREFPIECE(piece);
+            queue[self->nr_reuse++] = *row;
+        }
+    }
+    _c(self->tablePanel)->delContent(self->tablePanel, row->piece);
+
+    --self->nr_rows;
+    memmove(&self->rows[pos], &self->rows[pos + 1], (self->nr_rows - pos) * sizeof(TABLEVIEW_ROW));
+}
+
+static void s_materializeRow(mTableViewPiece* self, const mIndexPath* indexpath, int pos)
+{
+    TABLEVIEW_ROW row;
+    mPieceItem* item;
+    TABLEVIEW_ROW* rows;
+
+    rows = s_reserve(self->rows, &self->max_rows, self->nr_rows + 1, sizeof(TABLEVIEW_ROW));
+    if (NULL == rows)
+        return;
+    self->rows = rows;
+
+    row.indexpath = *indexpath;
+    row.defaultRow = NULL;
+    if (indexpath->row < 0) {
+        row.piece = (mHotPiece*)_c(self)->createIndexSectionHead(self, indexpath->section);
+        row.reuseType = -1;
+        if (NULL == row.piece)
+            return;
+    }
+    else {
+        int i;
+        const TABLEVIEW_ROW* recycled = NULL;
+        mTableViewItemPiece* item_piece;
+
+        row.reuseType = _c(self)->reuseTypeForRow(self, indexpath);
+        item_piece = _c(self)->createItemForRow(self, indexpath);
+        assert(INSTANCEOF(item_piece, mTableViewItemPiece));
+
+        for (i = 0; i < self->nr_dequeued; i++) {
+            if (self->dequeued[i].piece == (mHotPiece*)item_piece)
+                recycled = &self->dequeued[i];
+        }
+
+        /* a default row shows the text and picture of the row it was built for */
+        if (recycled && recycled->defaultRow
+                && _c(item_piece)->getUserPiece(item_piece) == recycled->defaultRow) {
+            _c(item_piece)->setUserPiece(item_piece, NULL);
+        }
+        if (!(_c(item_piece)->getUserPiece(item_piece))) {
+            mPanelPiece* panel = _c(self)->createDefaultRow(self, item_piece);
+            _c(item_piece)->setUserPiece(item_piece, (mHotPiece*)panel);
+            row.defaultRow = (mHotPiece*)panel;
+        }
+
+        /* a recycled row keeps its listeners */
+        if (!recycled) {
+            int event_ids[] = {NCSN_TABLEVIEWITEMPIECE_DELBTNCLICKED, 0};
+            ncsAddEventListeners((mObject*)item_piece, (mObject*)self,
+                    (NCS_CB_ONPIECEEVENT)onDeletePieceClicked, event_ids);
+            event_ids[0] = NCSN_TABLEVIEWITEMPIECE_CONTENTCLICKED;
+            ncsAddEventListeners((mObject*)item_piece, (mObject*)self,
+                    (NCS_CB_ONPIECEEVENT)onContentPieceClicked, event_ids);
+        }
+
+        item_piece->highlight = _c(self)->willSelectRowAtIndexPath(self, indexpath);
+        if ((int)item_piece->mode != self->mode)
+            _c(item_piece)->changeMode(item_piece);
+        row.piece = (mHotPiece*)item_piece;
+        s_measureRow(self, indexpath->section, indexpath->row);
+        s_fitRow(self, indexpath, row.piece);
+    }
+
+    item = _c(self->tablePanel)->addContent(self->tablePanel, row.piece,
+            0, s_rowTop(self, indexpath->section, indexpath->row));
+    _c(item)->setType(item, indexpath->row < 0 ? NCS_TABLEVIEW_TITLETYPE : NCS_TABLEVIEW_NORMALROWTYPE);
+    s_releaseDequeued(self);
+
+    memmove(&rows[pos + 1], &rows[pos], (self->nr_rows - pos) * sizeof(TABLEVIEW_ROW));
+    rows[pos] = row;
+    ++self->nr_rows;
+}
+
+/* rows below a newly measured one have moved */
+static void s_placeRows(mTableViewPiece* self)
+{
+    int i;
+    BOOL moved = FALSE;
+
+    for (i = 0; i < self->nr_rows; i++) {
+        const mIndexPath* ip = &self->rows[i].indexpath;
+        mPieceItem* item = _c(self->tablePanel)->searchItem(self->tablePanel, self->rows[i].piece);
+        int y = s_rowTop(self, ip->section, ip->row);
+
+        if (item && item->y != y) {
+            item->y = y;
+            moved = TRUE;
+        }
+    }
+
+    if (moved) {
+        PanelPiece_invalidateSpatialIndex(self->tablePanel);
+        _c(self)->invalidatePiece(self, (mHotPiece*)self->tablePanel, NULL, FALSE);
+    }
+}
+
+static void s_syncRows(mTableViewPiece* self)
+{
+    RECT rc;
+    int pos, top, bottom, delta;
+    int anchor_top = 0;
+    BOOL anchored;
+    mIndexPath indexpath, anchor;
+    mPieceItem* content;
+
+    if (!self->virtualized || self->nr_sections == 0)
+        return;
+
+    content = _c(self)->searchItem(self, (mHotPiece*)self->tablePanel);
+    do {
+        _c(self)->getViewport(self, &rc);
+        top = rc.top - self->overscan;
+        bottom = rc.bottom + self->overscan;
+
+        /* the row at the top of the viewport stays put while the rows
+         * above it get their exact heights */
+        anchored = s_locateRow(self, MAX(rc.top, 0), &anchor);
+        if (anchored)
+            anchor_top = s_rowTop(self, anchor.section, anchor.row);
+
+        /* hand the rows that left the window to the reuse queue */
+        for (pos = self->nr_rows - 1; pos >= 0; pos--) {
+            const mIndexPath* ip = &self->rows[pos].indexpath;
+            if (s_rowBottom(self, ip->section, ip->row) <= top
+                    || s_rowTop(self, ip->section, ip->row) >= bottom) {
+                s_recycleRow(self, pos);
+            }
+        }
+
+        if (s_locateRow(self, MAX(top, 0), &indexpath)) {
+            do {
+                if (s_rowTop(self, indexpath.section, indexpath.row) >= bottom)
+                    break;
+                if (!s_findRow(self, &indexpath, &pos))
+                    s_materializeRow(self, &indexpath, pos);
+            } while (s_nextRow(self, &indexpath));
+        }
+        s_placeRows(self);
+
+        delta = anchored ? s_rowTop(self, anchor.section, anchor.row) - anchor_top : 0;
+        if (delta != 0) {
+            /* not our movePiece, the loop syncs the shifted window */
+            Class(mScrollViewPiece).movePiece((mScrollViewPiece*)self,
+                    (mHotPiece*)self->tablePanel, content->x, content->y - delta);
+        }
+    } while (delta != 0);
+}
+
+static void s_freeSections(mTableViewPiece* self)
+{
+    int i;
+
+    for (i = 0; i < self->nr_sections; i++)
+        free(self->sections[i].rowHeights);
+    self->nr_sections = 0;
+}
+
+static void s_reloadRows(mTableViewPiece* self)
+{
+    RECT rc;
+    int i, row, header_h;
+    int section_num = _c(self)->numberOfSections(self);
+    TABLEVIEW_SECTION* sections;
+
+    while (self->nr_rows > 0)
+        s_recycleRow(self, self->nr_rows - 1);
+
+    s_freeSections(self);
+    sections = realloc(self->sections, MAX(section_num, 1) * sizeof(TABLEVIEW_SECTION));
+    if (NULL == sections)
+        return;
+    self->sections = sections;
+
+    _c(self)->getDefaultRowRect(self, &rc);
+    header_h = RECTH(rc);
+
+    /* estimates only, no row is built here */
+    for (i = 0; i < section_num; i++) {
+        TABLEVIEW_SECTION* sec = &sections[i];
+        const char* title;
+        int rows = MAX(_c(self)->numberOfRowsInSection(self, i), 0);
+
+        /* heights, offsets and measured flags share one block */
+        sec->rowHeights = malloc(rows * sizeof(int) + (rows + 1) * sizeof(int) + rows);
+        if (NULL == sec->rowHeights)
+            break;
+        sec->rowOffsets = sec->rowHeights + rows;
+        sec->measured = (unsigned char*)(sec->rowOffsets + rows + 1);
+        sec->rowOffsets[0] = 0;
+        sec->dirtyFrom = 0;
+        sec->rows = rows;
+
+        sec->headerHeight = 0;
+        if (self->style != NCS_TABLEVIEW_GROUP_STYLE) {
+            title = _c(self)->titleForSection(self, i);
+            if (title && strlen(title))
+                sec->headerHeight = header_h;
+        }
+
+        for (row = 0; row < rows; row++) {
+            mIndexPath indexpath = {i, row};
+            int height = _c(self)->estimatedHeightForRow(self, &indexpath);
+
+            sec->measured[row] = (height <= 0);
+            if (height <= 0)
+                height = _c(self)->heightForRowAtIndexPath(self, &indexpath);
+            sec->rowHeights[row] = height;
+        }
+    }
+    self->nr_sections = i;
+    self->sectionsDirtyFrom = 0;
+
+    /* s_updateSections sets the height */
+    rc.bottom = rc.top;
+    self->contentHeight = 0;
+    _c(self->tablePanel)->setRect(self->tablePanel, &rc);
+    s_updateSections(self);
+
+    autoAdjustTableViewPosition(self);
+    s_syncRows(self);
+}
+
+static void s_resetRows(mTableViewPiece* self)
+{
+    while (self->nr_rows > 0)
+        _c(self->tablePanel)->delContent(self->tablePanel, self->rows[--self->nr_rows].piece);
+    while (self->nr_reuse > 0) {
+        mHotPiece* piece = self->reuseQueue[--self->nr_reuse].piece;
+        UNREFPIECE(piece);
+    }
+    s_releaseDequeued(self);
+    s_freeSections(self);
+
+    free(self->rows);
+    free(self->reuseQueue);
+    free(self->dequeued);
+    free(self->sections);
+    self->rows = self->reuseQueue = NULL;
+    self->dequeued = NULL;
+    self->sections = NULL;
+    self->max_rows = self->max_reuse = self->max_dequeued = 0;
+    self->sectionsDirtyFrom = 0;
+    self->contentHeight = 0;
+}
+
+static void s_paintSeparators(mTableViewPiece* self, HDC hdc)
+{
+    RECT rc;
+    int i, x, y;
+    mPieceItem* content;
+
+    if (!self->virtualized || s_separatorHeight(self) == 0)
+        return;
+
+    content = _c(self)->searchItem(self, (mHotPiece*)self->tablePanel);
+    _c(self->tablePanel)->getRect(self->tablePanel, &rc);
+    x = content->x;
+    y = content->y;
+    SetBrushColor(hdc, ncsColor2Pixel(hdc, self->separatorColor));
+
+    /* the lines the section panels would carry as separator pieces */
+    for (i = 0; i < self->nr_rows; i++) {
+        const mIndexPath* ip = &self->rows[i].indexpath;
+        int margin, top;
+
+        if (ip->row < 0)
+            continue;
+
+        margin = ip->row == 0 ? 0 : NCS_TABLEVIEW_SEPARATOR_MARGIN_LEFT;
+        top = y + s_rowTop(self, ip->section, ip->row);
+        FillBox(hdc, x + margin, top - 1, RECTW(rc) - margin, 1);
+        if (ip->row == self->sections[ip->section].rows - 1)
+            FillBox(hdc, x, y + s_rowBottom(self, ip->section, ip->row), RECTW(rc), 1);
+    }
+}
@@ -106,6 +106,31 @@ static BOOL mShapeTransRoundPiece_setGradientFillColors (mShapeTransRoundPiece*
     return TRUE;
 }
 
+/* the part of the piece every paint covers with opaque pixels */
+static BOOL mShapeTransRoundPiece_getOpaqueRect(mShapeTransRoundPiece* self, RECT *prc)
+{
+    if (self->fill_mode != NCSP_TRANROUND_SINGLE_FILL
+            || GetAValue(self->bk_color) != 0xff)
+        return FALSE;
+
+    _c(self)->getRect(self, prc);
+    if (self->border_size && (self->use_gradient_border
+                || GetAValue(self->border_color) != 0xff)) {
+        InflateRect(prc, -self->border_size, -self->border_size);
+    }
+    /* leave out the rows of the round corners and the columns of the sharps */
+    if (self->corner_radius && (self->corner_flag & 0xf)) {
+        prc->top += self->corner_radius;
+        prc->bottom -= self->corner_radius;
+    }
+    if (self->sharp_flag & TRANROUND_SHARPFLAG_LEFT)
+        prc->left += self->sharp_width;
+    if (self->sharp_flag & TRANROUND_SHARPFLAG_RIGHT)
+        prc->right -= self->sharp_width;
+
+    return !IsRectEmpty(prc);
+}
+
 static BOOL mShapeTransRoundPiece_setProperty(mShapeTransRoundPiece* self, int id, DWORD value)
 {
     switch (id) {
@@ -713,6 +738,7 @@ BEGIN_MINI_CLASS(mShapeTransRoundPiece, mStaticPiece)
         CLASS_METHOD_MAP(mShapeTransRoundPiece, setGradientFillColors);
         CLASS_METHOD_MAP(mShapeTransRoundPiece, getBrush);
         CLASS_METHOD_MAP(mShapeTransRoundPiece, getBorderBrush);
+        CLASS_METHOD_MAP(mShapeTransRoundPiece, getOpaqueRect);
 END_MINI_CLASS
 
 // global functions